@@ -0,0 +1,532 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  The directory-index is a cache of the information ristretto needs
+ *  to populate an image-list, it allows a directory to be shown
+ *  before it has been enumerated.
+ *
+ *  File layout (host byte-order, the magic doubles as a byte-order
+ *  check):
+ *
+ *    RsttoDirIndexHeader
+ *    RsttoDirIndexRecord[n_entries]   (sorted by name)
+ *    string-table                     (nul-terminated strings)
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+
+#include <libexif/exif-data.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "util.h"
+#include "file.h"
+#include "dir_index.h"
+
+#define RSTTO_DIR_INDEX_MAGIC   0x58444952 /* "RIDX" */
+#define RSTTO_DIR_INDEX_VERSION 1
+
+typedef struct _RsttoDirIndexHeader RsttoDirIndexHeader;
+typedef struct _RsttoDirIndexRecord RsttoDirIndexRecord;
+
+struct _RsttoDirIndexHeader
+{
+    guint32 magic;
+    guint32 version;
+    guint64 dir_mtime;
+    guint32 n_entries;
+    guint32 strings_offset;
+    guint32 strings_size;
+    guint32 reserved;
+};
+
+struct _RsttoDirIndexRecord
+{
+    guint32 name;
+    guint32 content_type;
+    guint64 modified_time;
+    guint64 size;
+    gint64  capture_time;
+    gint32  width;
+    gint32  height;
+    gint32  orientation;
+    guint32 reserved;
+};
+
+struct _RsttoDirIndex
+{
+    GMappedFile *mapped_file;
+
+    const RsttoDirIndexHeader *header;
+    const RsttoDirIndexRecord *records;
+    const gchar               *strings;
+
+    gboolean current;
+};
+
+typedef struct {
+    gchar     *name;
+    RsttoFile *file;
+    const RsttoDirIndexEntry *entry;
+} RsttoDirIndexItem;
+
+static gchar *
+rstto_dir_index_get_path (GFile *dir, gboolean create)
+{
+    gchar *uri = g_file_get_uri (dir);
+    gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+    gchar *resource = g_strconcat ("ristretto/index/", checksum, ".idx", NULL);
+    gchar *path = NULL;
+
+    if (create)
+    {
+        path = xfce_resource_save_location (XFCE_RESOURCE_CACHE, resource, TRUE);
+    }
+    else
+    {
+        path = xfce_resource_lookup (XFCE_RESOURCE_CACHE, resource);
+    }
+
+    g_free (resource);
+    g_free (checksum);
+    g_free (uri);
+
+    return path;
+}
+
+/**
+ * rstto_dir_index_query_mtime:
+ * @dir:
+ *
+ * Return value: the modification-time of @dir, 0 if it can not be
+ *               determined.
+ */
+guint64
+rstto_dir_index_query_mtime (GFile *dir)
+{
+    GFileInfo *file_info;
+    guint64 mtime = 0;
+
+    file_info = g_file_query_info (
+            dir,
+            G_FILE_ATTRIBUTE_TIME_MODIFIED,
+            0,
+            NULL,
+            NULL);
+    if (NULL != file_info)
+    {
+        mtime = g_file_info_get_attribute_uint64 (
+                file_info,
+                G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        g_object_unref (file_info);
+    }
+
+    return mtime;
+}
+
+/**
+ * rstto_dir_index_load:
+ * @dir:       Directory
+ * @dir_mtime: The current modification-time of @dir
+ *
+ * Map the index of @dir into memory, the index is validated before
+ * it is returned. An index that was written for a different
+ * modification-time of @dir is returned too, it can still be used
+ * as a starting point, see rstto_dir_index_is_current().
+ *
+ * Return value: the index, or NULL if there is no usable index.
+ */
+RsttoDirIndex *
+rstto_dir_index_load (GFile *dir, guint64 dir_mtime)
+{
+    RsttoDirIndex *index = NULL;
+    GMappedFile *mapped_file;
+    const RsttoDirIndexHeader *header;
+    const RsttoDirIndexRecord *records;
+    const gchar *contents;
+    gsize length;
+    gchar *path;
+    guint i;
+
+    path = rstto_dir_index_get_path (dir, FALSE);
+    if (NULL == path)
+    {
+        return NULL;
+    }
+
+    mapped_file = g_mapped_file_new (path, FALSE, NULL);
+    g_free (path);
+
+    if (NULL == mapped_file)
+    {
+        return NULL;
+    }
+
+    contents = g_mapped_file_get_contents (mapped_file);
+    length = g_mapped_file_get_length (mapped_file);
+    header = (const RsttoDirIndexHeader *)contents;
+    records = (const RsttoDirIndexRecord *)(contents + sizeof (RsttoDirIndexHeader));
+
+    /* Validate the header, never trust a file from disk */
+    if ( (length < sizeof (RsttoDirIndexHeader)) ||
+         (header->magic != RSTTO_DIR_INDEX_MAGIC) ||
+         (header->version != RSTTO_DIR_INDEX_VERSION) ||
+         (header->n_entries > (length / sizeof (RsttoDirIndexRecord))) ||
+         (header->strings_offset < sizeof (RsttoDirIndexHeader) +
+                 (gsize)header->n_entries * sizeof (RsttoDirIndexRecord)) ||
+         (header->strings_size == 0) ||
+         ((gsize)header->strings_offset + header->strings_size > length) ||
+         (contents[header->strings_offset + header->strings_size - 1] != '\0') )
+    {
+        g_mapped_file_unref (mapped_file);
+        return NULL;
+    }
+
+    for (i = 0; i < header->n_entries; ++i)
+    {
+        if ( (records[i].name >= header->strings_size) ||
+             (records[i].content_type >= header->strings_size) )
+        {
+            g_mapped_file_unref (mapped_file);
+            return NULL;
+        }
+    }
+
+    index = g_new0 (RsttoDirIndex, 1);
+    index->mapped_file = mapped_file;
+    index->header = header;
+    index->records = records;
+    index->strings = contents + header->strings_offset;
+    index->current = (header->dir_mtime == dir_mtime);
+
+    return index;
+}
+
+void
+rstto_dir_index_free (RsttoDirIndex *index)
+{
+    if (NULL != index)
+    {
+        g_mapped_file_unref (index->mapped_file);
+        g_free (index);
+    }
+}
+
+/**
+ * rstto_dir_index_is_current:
+ * @index:
+ *
+ * Return value: TRUE if the directory has not been modified since
+ *               the index was written, files that have been modified
+ *               in-place can only be detected by their mtime.
+ */
+gboolean
+rstto_dir_index_is_current (RsttoDirIndex *index)
+{
+    return index->current;
+}
+
+guint
+rstto_dir_index_get_n_entries (RsttoDirIndex *index)
+{
+    return index->header->n_entries;
+}
+
+/**
+ * rstto_dir_index_get_entry:
+ * @index:
+ * @n:
+ * @entry: Entry to fill, the strings point into the mapped index
+ *         and are valid until the index is freed.
+ *
+ */
+gboolean
+rstto_dir_index_get_entry (
+        RsttoDirIndex *index,
+        guint n,
+        RsttoDirIndexEntry *entry)
+{
+    const RsttoDirIndexRecord *record;
+
+    if (n >= index->header->n_entries)
+    {
+        return FALSE;
+    }
+
+    record = &index->records[n];
+
+    entry->name = index->strings + record->name;
+    entry->content_type = index->strings + record->content_type;
+    entry->modified_time = record->modified_time;
+    entry->size = record->size;
+    entry->capture_time = record->capture_time;
+    entry->width = record->width;
+    entry->height = record->height;
+    entry->orientation = record->orientation;
+
+    return TRUE;
+}
+
+/**
+ * rstto_dir_index_entry_copy:
+ * @entry:
+ *
+ * Copy an entry so it outlives the index it was read from, only the
+ * name, content-type, modification-time and size are kept.
+ *
+ * Return value: the copy, free it with rstto_dir_index_entry_free().
+ */
+RsttoDirIndexEntry *
+rstto_dir_index_entry_copy (const RsttoDirIndexEntry *entry)
+{
+    RsttoDirIndexEntry *copy = g_new0 (RsttoDirIndexEntry, 1);
+
+    copy->name = g_strdup (entry->name);
+    /* Content-types are shared by nearly all entries */
+    copy->content_type = g_intern_string (entry->content_type);
+    copy->modified_time = entry->modified_time;
+    copy->size = entry->size;
+
+    return copy;
+}
+
+void
+rstto_dir_index_entry_free (RsttoDirIndexEntry *entry)
+{
+    g_free ((gchar *)entry->name);
+    g_free (entry);
+}
+
+/**
+ * rstto_dir_index_lookup:
+ * @index:
+ * @name: basename of the file
+ *
+ * Return value: position of @name in the index, -1 if not found.
+ */
+gint
+rstto_dir_index_lookup (
+        RsttoDirIndex *index,
+        const gchar *name)
+{
+    gint lower = 0;
+    gint upper = (gint)index->header->n_entries - 1;
+    gint middle;
+    gint cmp;
+
+    while (lower <= upper)
+    {
+        middle = lower + (upper - lower) / 2;
+        cmp = strcmp (name, index->strings + index->records[middle].name);
+        if (cmp == 0)
+        {
+            return middle;
+        }
+        if (cmp < 0)
+        {
+            upper = middle - 1;
+        }
+        else
+        {
+            lower = middle + 1;
+        }
+    }
+    return -1;
+}
+
+static gint
+cb_rstto_dir_index_item_compare (gconstpointer a, gconstpointer b)
+{
+    return strcmp (
+            ((const RsttoDirIndexItem *)a)->name,
+            ((const RsttoDirIndexItem *)b)->name);
+}
+
+static guint32
+rstto_dir_index_add_string (
+        GString *strings,
+        GHashTable *offsets,
+        const gchar *str)
+{
+    gpointer offset;
+
+    if (NULL == str)
+    {
+        str = "";
+    }
+
+    /* Content-types are shared by nearly all entries, store them once */
+    if (g_hash_table_lookup_extended (offsets, str, NULL, &offset))
+    {
+        return GPOINTER_TO_UINT (offset);
+    }
+
+    offset = GUINT_TO_POINTER (strings->len);
+    g_string_append_len (strings, str, strlen (str) + 1);
+    g_hash_table_insert (offsets, (gpointer)str, offset);
+
+    return GPOINTER_TO_UINT (offset);
+}
+
+/**
+ * rstto_dir_index_save:
+ * @dir:           Directory
+ * @dir_mtime:     Modification-time of @dir when it was enumerated
+ * @files:         The RsttoFiles in @dir
+ * @other_entries: RsttoDirIndexEntries of the other regular files in
+ *                 @dir, so they are not sniffed again when the
+ *                 directory is reopened.
+ *
+ * Write the index for @dir, the file is replaced atomically so a
+ * concurrent reader never sees a partial index.
+ */
+gboolean
+rstto_dir_index_save (
+        GFile *dir,
+        guint64 dir_mtime,
+        GList *files,
+        GList *other_entries)
+{
+    RsttoDirIndexHeader header;
+    RsttoDirIndexRecord record;
+    RsttoDirIndexItem *items;
+    RsttoFile *r_file;
+    GHashTable *offsets;
+    GString *records;
+    GString *strings;
+    GList *iter;
+    gchar *path;
+    guint n_items = 0;
+    guint i;
+    gint width;
+    gint height;
+    gboolean ret_val = FALSE;
+
+    path = rstto_dir_index_get_path (dir, TRUE);
+    if (NULL == path)
+    {
+        return FALSE;
+    }
+
+    items = g_new0 (
+            RsttoDirIndexItem,
+            g_list_length (files) + g_list_length (other_entries) + 1);
+    for (iter = files; iter != NULL; iter = g_list_next (iter))
+    {
+        r_file = RSTTO_FILE (iter->data);
+        items[n_items].name = g_file_get_basename (rstto_file_get_file (r_file));
+        if (NULL != items[n_items].name)
+        {
+            items[n_items].file = r_file;
+            n_items++;
+        }
+    }
+    for (iter = other_entries; iter != NULL; iter = g_list_next (iter))
+    {
+        items[n_items].entry = iter->data;
+        items[n_items].name = g_strdup (items[n_items].entry->name);
+        n_items++;
+    }
+    qsort (items, n_items, sizeof (RsttoDirIndexItem), cb_rstto_dir_index_item_compare);
+
+    offsets = g_hash_table_new (g_str_hash, g_str_equal);
+    records = g_string_sized_new (n_items * sizeof (RsttoDirIndexRecord));
+    strings = g_string_new ("");
+
+    /* Offset 0 is the empty string */
+    rstto_dir_index_add_string (strings, offsets, "");
+
+    for (i = 0; i < n_items; ++i)
+    {
+        r_file = items[i].file;
+
+        memset (&record, 0, sizeof (RsttoDirIndexRecord));
+        record.name = rstto_dir_index_add_string (
+                strings,
+                offsets,
+                items[i].name);
+
+        if (NULL == r_file)
+        {
+            record.content_type = rstto_dir_index_add_string (
+                    strings,
+                    offsets,
+                    items[i].entry->content_type);
+            record.modified_time = items[i].entry->modified_time;
+            record.size = items[i].entry->size;
+
+            g_string_append_len (records, (const gchar *)&record, sizeof (RsttoDirIndexRecord));
+            continue;
+        }
+
+        record.content_type = rstto_dir_index_add_string (
+                strings,
+                offsets,
+                rstto_file_get_content_type (r_file));
+        record.modified_time = rstto_file_get_modified_time (r_file);
+        record.size = rstto_file_get_size (r_file);
+
+        /* Only store the orientation if it is known, determining it
+         * here would defeat the purpose of the index.
+         */
+        if (rstto_file_has_orientation (r_file))
+        {
+            record.orientation = rstto_file_get_orientation (r_file);
+        }
+        record.capture_time = rstto_file_get_capture_time (r_file);
+        rstto_file_get_dimensions (r_file, &width, &height);
+        record.width = width;
+        record.height = height;
+
+        g_string_append_len (records, (const gchar *)&record, sizeof (RsttoDirIndexRecord));
+    }
+
+    memset (&header, 0, sizeof (RsttoDirIndexHeader));
+    header.magic = RSTTO_DIR_INDEX_MAGIC;
+    header.version = RSTTO_DIR_INDEX_VERSION;
+    header.dir_mtime = dir_mtime;
+    header.n_entries = n_items;
+    header.strings_offset = sizeof (RsttoDirIndexHeader) + records->len;
+    header.strings_size = strings->len;
+
+    g_string_prepend_len (records, (const gchar *)&header, sizeof (RsttoDirIndexHeader));
+    g_string_append_len (records, strings->str, strings->len);
+
+    /* g_file_set_contents writes to a temporary file and renames it */
+    ret_val = g_file_set_contents (path, records->str, records->len, NULL);
+
+    for (i = 0; i < n_items; ++i)
+    {
+        g_free (items[i].name);
+    }
+    g_free (items);
+
+    g_hash_table_destroy (offsets);
+    g_string_free (records, TRUE);
+    g_string_free (strings, TRUE);
+    g_free (path);
+
+    return ret_val;
+}
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_DIR_INDEX_H__
+#define __RISTRETTO_DIR_INDEX_H__
+
+G_BEGIN_DECLS
+
+typedef struct _RsttoDirIndex RsttoDirIndex;
+typedef struct _RsttoDirIndexEntry RsttoDirIndexEntry;
+
+struct _RsttoDirIndexEntry
+{
+    const gchar *name;
+    const gchar *content_type;
+
+    guint64 modified_time;
+    guint64 size;
+
+    gint64  capture_time;
+    gint    width;
+    gint    height;
+
+    RsttoImageOrientation orientation;
+};
+
+RsttoDirIndex *
+rstto_dir_index_load (
+        GFile *dir,
+        guint64 dir_mtime);
+
+void
+rstto_dir_index_free (
+        RsttoDirIndex *index);
+
+gboolean
+rstto_dir_index_is_current (
+        RsttoDirIndex *index);
+
+guint
+rstto_dir_index_get_n_entries (
+        RsttoDirIndex *index);
+
+gboolean
+rstto_dir_index_get_entry (
+        RsttoDirIndex *index,
+        guint n,
+        RsttoDirIndexEntry *entry);
+
+gint
+rstto_dir_index_lookup (
+        RsttoDirIndex *index,
+        const gchar *name);
+
+gboolean
+rstto_dir_index_save (
+        GFile *dir,
+        guint64 dir_mtime,
+        GList *files,
+        GList *other_entries);
+
+RsttoDirIndexEntry *
+rstto_dir_index_entry_copy (
+        const RsttoDirIndexEntry *entry);
+
+void
+rstto_dir_index_entry_free (
+        RsttoDirIndexEntry *entry);
+
+guint64
+rstto_dir_index_query_mtime (
+        GFile *dir);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_DIR_INDEX_H__ */
@@ -29,23 +29,45 @@
 
 #include "util.h"
 #include "file.h"
-#include "thumbnailer.h"
+#include "metadata.h"
+#include "thumbnail_loader.h"
+#include "thumbnail_cache.h"
 
-static guint rstto_thumbnail_size[] =
+enum
 {
-    THUMBNAIL_SIZE_VERY_SMALL_SIZE,
-    THUMBNAIL_SIZE_SMALLER_SIZE,
-    THUMBNAIL_SIZE_SMALL_SIZE,
-    THUMBNAIL_SIZE_NORMAL_SIZE,
-    THUMBNAIL_SIZE_LARGE_SIZE,
-    THUMBNAIL_SIZE_LARGER_SIZE,
-    THUMBNAIL_SIZE_VERY_LARGE_SIZE
+    RSTTO_FILE_SIGNAL_CHANGED = 0,
+    RSTTO_FILE_SIGNAL_METADATA_READY,
+    RSTTO_FILE_SIGNAL_COUNT
 };
 
 enum
 {
-    RSTTO_FILE_SIGNAL_CHANGED = 0,
-    RSTTO_FILE_SIGNAL_COUNT
+    RSTTO_METADATA_STATE_NONE = 0,
+    RSTTO_METADATA_STATE_PENDING,
+    RSTTO_METADATA_STATE_LOADED
+};
+
+typedef struct _RsttoMetadataRequest RsttoMetadataRequest;
+typedef struct _RsttoFileDetails RsttoFileDetails;
+
+struct _RsttoMetadataRequest
+{
+    RsttoFile     *r_file;
+    gchar         *path;
+    guint          generation;
+    RsttoMetadata  metadata;
+};
+
+/* The metadata that is only shown for the current image, allocated
+ * when any of it is known.
+ */
+struct _RsttoFileDetails
+{
+    gint    width;
+    gint    height;
+    gchar  *model;
+    gdouble f_number;
+    gdouble exposure_time;
 };
 
 static gint
@@ -74,9 +96,27 @@ rstto_file_get_property (
         GValue     *value,
         GParamSpec *pspec );
 
+static void
+rstto_file_clear_metadata ( RsttoFile *r_file );
+
+static void
+cb_rstto_file_read_metadata (
+        gpointer data,
+        gpointer user_data);
+static gboolean
+cb_rstto_file_metadata_ready (
+        gpointer user_data);
+
 static GObjectClass *parent_class = NULL;
 
-static GList *open_files = NULL;
+/* Reads the metadata of files, off the UI thread */
+static GThreadPool *metadata_pool = NULL;
+
+/* GFile -> RsttoFile, the RsttoFiles are not referenced by the
+ * table, they are removed from it when they are disposed.
+ */
+static GHashTable *open_files = NULL;
+G_LOCK_DEFINE_STATIC (open_files);
 
 enum
 {
@@ -113,22 +153,43 @@ rstto_file_get_type (void)
     return rstto_file_type;
 }
 
+/* There is an RsttoFile for every file in the image-list, keep this
+ * small. Everything that is not needed to list and sort the files is
+ * allocated on demand.
+ */
 struct _RsttoFilePriv
 {
     GFile *file;
 
     gchar *display_name;
-    gchar *content_type;
+
+    /* Interned, shared by all files of the same type */
+    const gchar *content_type;
 
     gchar *uri;
     gchar *path;
     gchar *collate_key;
 
-    gchar *thumbnail_path;
-    GdkPixbuf *thumbnails[THUMBNAIL_SIZE_COUNT];
-
+    /* The full EXIF data, only loaded for the properties-dialog */
     ExifData *exif_data;
     RsttoImageOrientation orientation;
+
+    /* Header-only metadata, see metadata.c. The capture-time is
+     * needed to sort the list, the rest is allocated on demand.
+     */
+    gint64 capture_time;
+    RsttoFileDetails *details;
+    guint metadata_state : 2;
+    /* Bumped by rstto_file_changed, to recognize stale requests */
+    guint metadata_generation;
+
+    /* RsttoThumbnailState per flavor, reset by rstto_file_changed */
+    guint8 thumbnail_state[THUMBNAIL_FLAVOR_COUNT];
+
+    /* Cached file-info, reset by rstto_file_changed */
+    guint64 modified_time;
+    guint64 size;
+    guint file_info_valid : 1;
 };
 
 
@@ -137,7 +198,13 @@ rstto_file_init (GObject *object)
 {
     RsttoFile *r_file = RSTTO_FILE (object);
 
-    r_file->priv = g_new0 (RsttoFilePriv, 1);
+    /* The private data is part of the instance, not a separate
+     * allocation.
+     */
+    r_file->priv = G_TYPE_INSTANCE_GET_PRIVATE (
+            object,
+            RSTTO_TYPE_FILE,
+            RsttoFilePriv);
 }
 
 
@@ -148,6 +215,8 @@ rstto_file_class_init (GObjectClass *object_class)
 
     parent_class = g_type_class_peek_parent (file_class);
 
+    g_type_class_add_private (object_class, sizeof (RsttoFilePriv));
+
     object_class->dispose = rstto_file_dispose;
     object_class->finalize = rstto_file_finalize;
 
@@ -164,6 +233,17 @@ rstto_file_class_init (GObjectClass *object_class)
             G_TYPE_NONE,
             0,
             NULL);
+
+    rstto_file_signals[RSTTO_FILE_SIGNAL_METADATA_READY] = g_signal_new("metadata-ready",
+            G_TYPE_FROM_CLASS(object_class),
+            G_SIGNAL_RUN_LAST,
+            0,
+            NULL,
+            NULL,
+            g_cclosure_marshal_VOID__VOID,
+            G_TYPE_NONE,
+            0,
+            NULL);
 }
 
 /**
@@ -175,10 +255,28 @@ static void
 rstto_file_dispose (GObject *object)
 {
     RsttoFile *r_file = RSTTO_FILE (object);
-    gint i = 0;
 
     if (r_file->priv)
     {
+        G_LOCK (open_files);
+
+        /* rstto_file_new may have returned this file from another
+         * thread, after the last reference was dropped.
+         */
+        if (object->ref_count > 1)
+        {
+            G_UNLOCK (open_files);
+            return;
+        }
+
+        if ( (NULL != r_file->priv->file) &&
+             (g_hash_table_lookup (open_files, r_file->priv->file) == r_file) )
+        {
+            g_hash_table_remove (open_files, r_file->priv->file);
+        }
+
+        G_UNLOCK (open_files);
+
         if (r_file->priv->file)
         {
             g_object_unref (r_file->priv->file);
@@ -189,21 +287,12 @@ rstto_file_dispose (GObject *object)
             g_free (r_file->priv->display_name);
             r_file->priv->display_name = NULL;
         }
-        if (r_file->priv->content_type)
-        {
-            g_free (r_file->priv->content_type);
-            r_file->priv->content_type = NULL;
-        }
+        r_file->priv->content_type = NULL;
         if (r_file->priv->path)
         {
             g_free (r_file->priv->path);
             r_file->priv->path = NULL;
         }
-        if (r_file->priv->thumbnail_path)
-        {
-            g_free (r_file->priv->thumbnail_path);
-            r_file->priv->thumbnail_path = NULL;
-        }
         if (r_file->priv->uri)
         {
             g_free (r_file->priv->uri);
@@ -215,19 +304,12 @@ rstto_file_dispose (GObject *object)
             r_file->priv->collate_key = NULL;
         }
 
-        for (i = 0; i < THUMBNAIL_SIZE_COUNT; ++i)
-        {
-            if (r_file->priv->thumbnails[i])
-            {
-                g_object_unref (r_file->priv->thumbnails[i]);
-                r_file->priv->thumbnails[i] = NULL;
-            }
-        }
+        rstto_file_clear_metadata (r_file);
 
-        g_free (r_file->priv);
-        r_file->priv = NULL;
+        rstto_thumbnail_cache_remove (r_file);
 
-        open_files = g_list_remove_all (open_files, r_file);
+        /* The private data is freed with the instance */
+        r_file->priv = NULL;
     }
 }
 
@@ -248,35 +330,41 @@ rstto_file_finalize (GObject *object)
  * rstto_file_new:
  *
  *
- * Singleton
+ * Singleton, there is one RsttoFile per file. It is safe to call
+ * from any thread.
  */
 RsttoFile *
 rstto_file_new ( GFile *file )
 {
     RsttoFile *r_file = NULL;
-    GList *iter = open_files;
 
-    while ( NULL != iter )
+    G_LOCK (open_files);
+
+    if ( NULL == open_files )
     {
-        /* Check if the file is already opened, if so
-         * return that one.
-         */
-        r_file = RSTTO_FILE (iter->data);
-        if ( TRUE == g_file_equal (
-                r_file->priv->file,
-                file) )
-        {
-            g_object_ref (G_OBJECT (iter->data));
-            return (RsttoFile *)iter->data;
-        }
-        iter = g_list_next (iter);
+        open_files = g_hash_table_new (
+                g_file_hash,
+                (GEqualFunc)g_file_equal);
+    }
+
+    /* Check if the file is already opened, if so
+     * return that one.
+     */
+    r_file = g_hash_table_lookup (open_files, file);
+    if ( NULL != r_file )
+    {
+        g_object_ref (G_OBJECT (r_file));
     }
+    else
+    {
+        r_file = g_object_new (RSTTO_TYPE_FILE, NULL);
+        r_file->priv->file = file;
+        g_object_ref (file);
 
-    r_file = g_object_new (RSTTO_TYPE_FILE, NULL);
-    r_file->priv->file = file;
-    g_object_ref (file);
+        g_hash_table_insert (open_files, r_file->priv->file, r_file);
+    }
 
-    open_files = g_list_append (open_files, r_file);
+    G_UNLOCK (open_files);
 
     return r_file;
 }
@@ -408,26 +496,92 @@ rstto_file_get_content_type ( RsttoFile *r_file )
             content_type = g_file_info_get_content_type (file_info);
             if ( NULL != content_type )
             {
-                r_file->priv->content_type = g_strdup (content_type);
+                r_file->priv->content_type = g_intern_string (content_type);
             }
             g_object_unref (file_info);
         }
     }
 
-    return (const gchar *)r_file->priv->content_type;
+    return r_file->priv->content_type;
+}
+
+static void
+rstto_file_query_file_info ( RsttoFile *r_file )
+{
+    GFileInfo *file_info = NULL;
+
+    if ( FALSE == r_file->priv->file_info_valid )
+    {
+        file_info = g_file_query_info (
+                r_file->priv->file,
+                "time::modified,standard::size",
+                0,
+                NULL,
+                NULL );
+        if ( NULL != file_info )
+        {
+            r_file->priv->modified_time = g_file_info_get_attribute_uint64 (
+                    file_info,
+                    "time::modified" );
+            r_file->priv->size = g_file_info_get_attribute_uint64 (
+                    file_info,
+                    "standard::size" );
+            g_object_unref (file_info);
+        }
+        r_file->priv->file_info_valid = TRUE;
+    }
+}
+
+/**
+ * rstto_file_set_content_type:
+ * @r_file:
+ * @content_type:
+ *
+ * Set the content-type if it is already known, eg. from the
+ * file-enumerator or the directory-index, to avoid sniffing the
+ * file again.
+ */
+void
+rstto_file_set_content_type (
+        RsttoFile *r_file,
+        const gchar *content_type )
+{
+    r_file->priv->content_type = g_intern_string (content_type);
 }
 
 guint64
 rstto_file_get_modified_time ( RsttoFile *r_file )
 {
-    guint64 time_ = 0;
-    GFileInfo *file_info = g_file_query_info (r_file->priv->file, "time::modified", 0, NULL, NULL);
+    rstto_file_query_file_info (r_file);
 
-    time_ = g_file_info_get_attribute_uint64 ( file_info, "time::modified" );
+    return r_file->priv->modified_time;
+}
 
-    g_object_unref (file_info);
+guint64
+rstto_file_get_size ( RsttoFile *r_file )
+{
+    rstto_file_query_file_info (r_file);
+
+    return r_file->priv->size;
+}
 
-    return time_;
+/**
+ * rstto_file_set_file_info:
+ * @r_file:
+ * @modified_time:
+ * @size:
+ *
+ * Set the modification-time and size if they are already known.
+ */
+void
+rstto_file_set_file_info (
+        RsttoFile *r_file,
+        guint64 modified_time,
+        guint64 size )
+{
+    r_file->priv->modified_time = modified_time;
+    r_file->priv->size = size;
+    r_file->priv->file_info_valid = TRUE;
 }
 
 ExifEntry *
@@ -451,21 +605,296 @@ rstto_file_get_exif ( RsttoFile *r_file, ExifTag id )
     return NULL;
 }
 
+static void
+rstto_file_clear_metadata ( RsttoFile *r_file )
+{
+    r_file->priv->capture_time = 0;
+
+    if (NULL != r_file->priv->details)
+    {
+        g_free (r_file->priv->details->model);
+        g_free (r_file->priv->details);
+        r_file->priv->details = NULL;
+    }
+}
+
+static RsttoFileDetails *
+rstto_file_get_details ( RsttoFile *r_file )
+{
+    if (NULL == r_file->priv->details)
+    {
+        r_file->priv->details = g_new0 (RsttoFileDetails, 1);
+    }
+    return r_file->priv->details;
+}
+
+static void
+rstto_file_set_loaded_metadata (
+        RsttoFile *r_file,
+        RsttoMetadata *metadata)
+{
+    RsttoFileDetails *details;
+
+    rstto_file_clear_metadata (r_file);
+
+    r_file->priv->capture_time = metadata->capture_time;
+    r_file->priv->metadata_state = RSTTO_METADATA_STATE_LOADED;
+
+    if ( (metadata->width != 0) ||
+         (metadata->height != 0) ||
+         (NULL != metadata->model) ||
+         (metadata->f_number != 0) ||
+         (metadata->exposure_time != 0) )
+    {
+        details = rstto_file_get_details (r_file);
+        details->width = metadata->width;
+        details->height = metadata->height;
+        details->f_number = metadata->f_number;
+        details->exposure_time = metadata->exposure_time;
+
+        /* Takes over the string in metadata */
+        details->model = metadata->model;
+        metadata->model = NULL;
+    }
+
+    if ( (r_file->priv->orientation == 0) &&
+         (metadata->orientation != 0) )
+    {
+        r_file->priv->orientation = metadata->orientation;
+    }
+
+    g_signal_emit (
+            G_OBJECT (r_file),
+            rstto_file_signals[RSTTO_FILE_SIGNAL_METADATA_READY],
+            0,
+            NULL);
+}
+
+static void
+cb_rstto_file_read_metadata (
+        gpointer data,
+        gpointer user_data)
+{
+    RsttoMetadataRequest *request = data;
+
+    rstto_metadata_read (request->path, &request->metadata);
+
+    gdk_threads_add_idle (cb_rstto_file_metadata_ready, request);
+}
+
+static gboolean
+cb_rstto_file_metadata_ready (
+        gpointer user_data)
+{
+    RsttoMetadataRequest *request = user_data;
+    RsttoFile *r_file = request->r_file;
+
+    /* Discard the result if the file changed, or if the metadata was
+     * read synchronously in the meantime. A new request may already be
+     * pending after a change, so the state alone is not enough.
+     */
+    if ( (NULL != r_file->priv) &&
+         (r_file->priv->metadata_generation == request->generation) &&
+         (r_file->priv->metadata_state == RSTTO_METADATA_STATE_PENDING) )
+    {
+        rstto_file_set_loaded_metadata (r_file, &request->metadata);
+    }
+    else
+    {
+        rstto_metadata_clear (&request->metadata);
+    }
+
+    g_object_unref (r_file);
+    g_free (request->path);
+    g_free (request);
+
+    return FALSE;
+}
+
+/**
+ * rstto_file_load_metadata:
+ * @r_file:
+ *
+ * Read the metadata on a worker-thread, "metadata-ready" is emitted
+ * when it is available.
+ */
+void
+rstto_file_load_metadata ( RsttoFile *r_file )
+{
+    RsttoMetadataRequest *request;
+    const gchar *path;
+
+    if (r_file->priv->metadata_state != RSTTO_METADATA_STATE_NONE)
+    {
+        return;
+    }
+
+    path = rstto_file_get_path (r_file);
+    if (NULL == path)
+    {
+        /* Only local files are supported */
+        r_file->priv->metadata_state = RSTTO_METADATA_STATE_LOADED;
+        return;
+    }
+
+    if (NULL == metadata_pool)
+    {
+        metadata_pool = g_thread_pool_new (
+                cb_rstto_file_read_metadata,
+                NULL,
+                2,
+                FALSE,
+                NULL);
+    }
+
+    request = g_new0 (RsttoMetadataRequest, 1);
+    request->r_file = g_object_ref (r_file);
+    request->path = g_strdup (path);
+    request->generation = r_file->priv->metadata_generation;
+
+    r_file->priv->metadata_state = RSTTO_METADATA_STATE_PENDING;
+
+    g_thread_pool_push (metadata_pool, request, NULL);
+}
+
+gboolean
+rstto_file_has_metadata ( RsttoFile *r_file )
+{
+    return r_file->priv->metadata_state == RSTTO_METADATA_STATE_LOADED;
+}
+
+/**
+ * rstto_file_set_metadata:
+ * @r_file:
+ * @capture_time:
+ * @width:
+ * @height:
+ *
+ * Set the metadata if it is already known, eg. from the
+ * directory-index. It is still read from the file if it is
+ * requested with rstto_file_load_metadata.
+ */
+void
+rstto_file_set_metadata (
+        RsttoFile *r_file,
+        gint64 capture_time,
+        gint width,
+        gint height )
+{
+    RsttoFileDetails *details;
+
+    r_file->priv->capture_time = capture_time;
+
+    if ( (width != 0) || (height != 0) )
+    {
+        details = rstto_file_get_details (r_file);
+        details->width = width;
+        details->height = height;
+    }
+}
+
+/**
+ * rstto_file_get_capture_time:
+ * @r_file:
+ *
+ * Return value: the time the picture was taken, 0 if unknown or if
+ *               the metadata has not been loaded.
+ */
+gint64
+rstto_file_get_capture_time ( RsttoFile *r_file )
+{
+    return r_file->priv->capture_time;
+}
+
+/**
+ * rstto_file_get_dimensions:
+ * @r_file:
+ * @width:
+ * @height:
+ *
+ * Return value: TRUE if the dimensions are known.
+ */
+gboolean
+rstto_file_get_dimensions (
+        RsttoFile *r_file,
+        gint *width,
+        gint *height )
+{
+    *width = 0;
+    *height = 0;
+
+    if (NULL != r_file->priv->details)
+    {
+        *width = r_file->priv->details->width;
+        *height = r_file->priv->details->height;
+    }
+
+    return ( (*width > 0) && (*height > 0) );
+}
+
+const gchar *
+rstto_file_get_camera_model ( RsttoFile *r_file )
+{
+    if (NULL == r_file->priv->details)
+    {
+        return NULL;
+    }
+    return r_file->priv->details->model;
+}
+
+/**
+ * rstto_file_get_f_number:
+ * @r_file:
+ *
+ * Return value: The aperture, 0 if unknown or if the metadata has
+ *               not been loaded.
+ */
+gdouble
+rstto_file_get_f_number ( RsttoFile *r_file )
+{
+    if (NULL == r_file->priv->details)
+    {
+        return 0;
+    }
+    return r_file->priv->details->f_number;
+}
+
+/**
+ * rstto_file_get_exposure_time:
+ * @r_file:
+ *
+ * Return value: The exposure time in seconds, 0 if unknown or if the
+ *               metadata has not been loaded.
+ */
+gdouble
+rstto_file_get_exposure_time ( RsttoFile *r_file )
+{
+    if (NULL == r_file->priv->details)
+    {
+        return 0;
+    }
+    return r_file->priv->details->exposure_time;
+}
+
 RsttoImageOrientation
 rstto_file_get_orientation ( RsttoFile *r_file )
 {
-    ExifEntry *exif_entry = NULL;
+    RsttoMetadata metadata;
+    const gchar *path;
+
     if (r_file->priv->orientation == 0 )
     {
-        /* Try to get the default orientation from the EXIF tag */
-        exif_entry = rstto_file_get_exif (r_file, EXIF_TAG_ORIENTATION);
-        if (NULL != exif_entry)
+        /* Read the orientation from the EXIF header, this only
+         * reads a few KiB, unlike the full libexif parse.
+         */
+        if (r_file->priv->metadata_state != RSTTO_METADATA_STATE_LOADED)
         {
-            r_file->priv->orientation = exif_get_short (
-                    exif_entry->data,
-                    exif_data_get_byte_order (exif_entry->parent->parent));
-
-            exif_entry_free (exif_entry);
+            path = rstto_file_get_path (r_file);
+            if (NULL != path)
+            {
+                rstto_metadata_read (path, &metadata);
+                rstto_file_set_loaded_metadata (r_file, &metadata);
+            }
         }
 
         /* If the orientation-tag is not set, default to NONE */
@@ -487,6 +916,19 @@ rstto_file_set_orientation (
     r_file->priv->orientation = orientation;
 }
 
+/**
+ * rstto_file_has_orientation:
+ * @r_file:
+ *
+ * Return value: TRUE if the orientation has been determined, this
+ *               does not read the EXIF data.
+ */
+gboolean
+rstto_file_has_orientation ( RsttoFile *r_file )
+{
+    return r_file->priv->orientation != 0;
+}
+
 gboolean
 rstto_file_has_exif ( RsttoFile *r_file )
 {
@@ -501,86 +943,122 @@ rstto_file_has_exif ( RsttoFile *r_file )
     return TRUE;
 }
 
-const gchar *
-rstto_file_get_thumbnail_path ( RsttoFile *r_file)
+/**
+ * rstto_file_get_thumbnail:
+ * @r_file:
+ * @size:
+ *
+ * The thumbnail is loaded in the background if it is not in memory
+ * yet, wait for the "ready" signal of the RsttoThumbnailLoader. The
+ * loader requests a new thumbnail if it is missing or stale.
+ *
+ * If the thumbnail was regenerated, the old one is returned until
+ * the new one is loaded.
+ *
+ * Return value: the thumbnail, or NULL if it is not loaded.
+ */
+const GdkPixbuf *
+rstto_file_get_thumbnail (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size )
 {
-    const gchar *uri;
-    gchar *checksum;
-    gchar *filename;
+    const GdkPixbuf *pixbuf;
+    RsttoThumbnailLoader *loader;
 
-    if (NULL == r_file->priv->thumbnail_path)
-    {
-        uri = rstto_file_get_uri (r_file);
-        checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, strlen (uri));
-        filename = g_strconcat (checksum, ".png", NULL);
+    pixbuf = rstto_thumbnail_cache_lookup (r_file, size);
 
-        /* build and check if the thumbnail is in the new location */
-        r_file->priv->thumbnail_path = g_build_path ("/", g_get_user_cache_dir(), "thumbnails", "normal", filename, NULL);
-
-        if(!g_file_test (r_file->priv->thumbnail_path, G_FILE_TEST_EXISTS))
-        {
-            /* Fallback to old version */
-            g_free (r_file->priv->thumbnail_path);
-
-            r_file->priv->thumbnail_path = g_build_path ("/", g_get_home_dir(), ".thumbnails", "normal", filename, NULL);
-            if(!g_file_test (r_file->priv->thumbnail_path, G_FILE_TEST_EXISTS))
+    switch (r_file->priv->thumbnail_state[THUMBNAIL_SIZE_GET_FLAVOR (size)])
+    {
+        case RSTTO_THUMBNAIL_STATE_UNKNOWN:
+            break;
+        case RSTTO_THUMBNAIL_STATE_VALID:
+        case RSTTO_THUMBNAIL_STATE_STALE:
+            /* Only load the sizes that are not in memory */
+            if (NULL == pixbuf)
             {
-                /* Thumbnail doesn't exist in either spot */
-                g_free (r_file->priv->thumbnail_path);
-                r_file->priv->thumbnail_path = NULL;
+                break;
             }
-        }
-
-        g_free (checksum);
-        g_free (filename);
+            return pixbuf;
+        default:
+            /* Wait for the thumbnailer, or do not bother at all */
+            return pixbuf;
     }
 
-    return r_file->priv->thumbnail_path;
+    loader = rstto_thumbnail_loader_new ();
+    rstto_thumbnail_loader_load (loader, r_file, size);
+    g_object_unref (loader);
+
+    return pixbuf;
 }
 
+/**
+ * rstto_file_peek_thumbnail:
+ * @r_file:
+ * @size:
+ *
+ * Return value: the thumbnail if it is in memory, it is not loaded.
+ */
 const GdkPixbuf *
-rstto_file_get_thumbnail (
+rstto_file_peek_thumbnail (
         RsttoFile *r_file,
         RsttoThumbnailSize size )
 {
-    const gchar *thumbnail_path;
-    RsttoThumbnailer *thumbnailer;
-
-    if (r_file->priv->thumbnails[size])
-        return r_file->priv->thumbnails[size];
-
-    thumbnail_path = rstto_file_get_thumbnail_path (r_file);
-
-    thumbnailer = rstto_thumbnailer_new();
-    rstto_thumbnailer_queue_file (thumbnailer, r_file);
-
-    if (NULL == thumbnail_path)
-    {
-        /* No thumbnail to return at this time */
-        return NULL;
-    }
+    return rstto_thumbnail_cache_peek (r_file, size);
+}
 
-    /* FIXME:
-     *
-     * The thumbnail should be updated on the "ready" signal
-     * of the thumbnailer, to account for changed thumbnails
-     * aswell as missing ones.
-     */
-    r_file->priv->thumbnails[size] = gdk_pixbuf_new_from_file_at_scale (
-            thumbnail_path,
-            rstto_thumbnail_size[size],
-            rstto_thumbnail_size[size],
-            TRUE,
-            NULL);
+void
+rstto_file_set_thumbnail (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size,
+        GdkPixbuf *pixbuf )
+{
+    rstto_thumbnail_cache_insert (r_file, size, pixbuf);
+}
 
-    g_object_unref (thumbnailer);
+RsttoThumbnailState
+rstto_file_get_thumbnail_state (
+        RsttoFile *r_file,
+        RsttoThumbnailFlavor flavor )
+{
+    return r_file->priv->thumbnail_state[flavor];
+}
 
-    return r_file->priv->thumbnails[size];
+/**
+ * rstto_file_set_thumbnail_state:
+ * @r_file:
+ * @flavor:
+ * @state:
+ *
+ * Set to RSTTO_THUMBNAIL_STATE_UNKNOWN when a new thumbnail is
+ * written, it is loaded again on the next rstto_file_get_thumbnail.
+ */
+void
+rstto_file_set_thumbnail_state (
+        RsttoFile *r_file,
+        RsttoThumbnailFlavor flavor,
+        RsttoThumbnailState state )
+{
+    r_file->priv->thumbnail_state[flavor] = state;
 }
 
 void
 rstto_file_changed ( RsttoFile *r_file )
 {
+    gint i;
+
+    r_file->priv->file_info_valid = FALSE;
+
+    /* A pending metadata-request is discarded */
+    rstto_file_clear_metadata (r_file);
+    r_file->priv->metadata_state = RSTTO_METADATA_STATE_NONE;
+    r_file->priv->metadata_generation++;
+
+    /* Check the thumbnails against the new modification-time */
+    for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+    {
+        r_file->priv->thumbnail_state[i] = RSTTO_THUMBNAIL_STATE_UNKNOWN;
+    }
+
     g_signal_emit (
             G_OBJECT (r_file),
             rstto_file_signals[RSTTO_FILE_SIGNAL_CHANGED],
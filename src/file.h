@@ -87,18 +87,80 @@ rstto_file_get_collate_key ( RsttoFile * );
 const gchar *
 rstto_file_get_content_type ( RsttoFile * );
 
-const gchar *
-rstto_file_get_thumbnail_path ( RsttoFile *);
-
 const GdkPixbuf *
 rstto_file_get_thumbnail ( RsttoFile *, RsttoThumbnailSize );
 
+const GdkPixbuf *
+rstto_file_peek_thumbnail ( RsttoFile *, RsttoThumbnailSize );
+
+void
+rstto_file_set_thumbnail (
+        RsttoFile *,
+        RsttoThumbnailSize,
+        GdkPixbuf * );
+
+RsttoThumbnailState
+rstto_file_get_thumbnail_state (
+        RsttoFile *,
+        RsttoThumbnailFlavor );
+
+void
+rstto_file_set_thumbnail_state (
+        RsttoFile *,
+        RsttoThumbnailFlavor,
+        RsttoThumbnailState );
+
+void
+rstto_file_set_content_type (
+        RsttoFile *,
+        const gchar * );
+
 guint64
 rstto_file_get_modified_time ( RsttoFile *);
 
+guint64
+rstto_file_get_size ( RsttoFile *);
+
+void
+rstto_file_set_file_info (
+        RsttoFile *,
+        guint64,
+        guint64 );
+
 ExifEntry *
 rstto_file_get_exif ( RsttoFile *, ExifTag );
 
+void
+rstto_file_load_metadata ( RsttoFile * );
+
+gboolean
+rstto_file_has_metadata ( RsttoFile * );
+
+void
+rstto_file_set_metadata (
+        RsttoFile *,
+        gint64,
+        gint,
+        gint );
+
+gint64
+rstto_file_get_capture_time ( RsttoFile * );
+
+gboolean
+rstto_file_get_dimensions (
+        RsttoFile *,
+        gint *,
+        gint * );
+
+const gchar *
+rstto_file_get_camera_model ( RsttoFile * );
+
+gdouble
+rstto_file_get_f_number ( RsttoFile * );
+
+gdouble
+rstto_file_get_exposure_time ( RsttoFile * );
+
 RsttoImageOrientation
 rstto_file_get_orientation ( RsttoFile * );
 
@@ -107,6 +169,9 @@ rstto_file_set_orientation (
         RsttoFile * ,
         RsttoImageOrientation );
 
+gboolean
+rstto_file_has_orientation ( RsttoFile * );
+
 gboolean
 rstto_file_has_exif ( RsttoFile * );
 
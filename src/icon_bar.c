@@ -36,6 +36,9 @@
 #include "util.h"
 #include "file.h"
 #include "thumbnailer.h"
+#include "thumbnail_loader.h"
+#include "thumbnail_cache.h"
+#include "thumbnail_atlas.h"
 #include "settings.h"
 #include "marshal.h"
 #include "icon_bar.h"
@@ -43,6 +46,13 @@
 #define MINIMUM_ICON_ITEM_WIDTH 32
 #define ICON_TEXT_PADDING 1
 
+/* Stop prefetching while this many thumbnails are being loaded */
+#define RSTTO_ICON_BAR_PREFETCH_MAX_PENDING 8
+/* Time to wait before prefetching more thumbnails, in milliseconds */
+#define RSTTO_ICON_BAR_PREFETCH_DELAY 50
+/* Number of items on either side of the visible ones with a cached iter */
+#define RSTTO_ICON_BAR_WINDOW_MARGIN 8
+
 #define RSTTO_ICON_BAR_GET_PRIVATE(obj) ( \
             G_TYPE_INSTANCE_GET_PRIVATE ( \
                     (obj), \
@@ -55,8 +65,6 @@
 
 
 
-typedef struct _RsttoIconBarItem RsttoIconBarItem;
-
 enum
 {
     PROP_0,
@@ -159,7 +167,7 @@ cb_rstto_icon_bar_adjustment_value_changed (
 static void
 rstto_icon_bar_invalidate (RsttoIconBar *icon_bar);
 
-static RsttoIconBarItem *
+static gint
 rstto_icon_bar_get_item_at_pos (
         RsttoIconBar *icon_bar,
         gint          x,
@@ -167,19 +175,22 @@ rstto_icon_bar_get_item_at_pos (
 
 static void
 rstto_icon_bar_queue_draw_item (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item);
+        RsttoIconBar *icon_bar,
+        gint          idx);
 
 static void
 rstto_icon_bar_paint_item (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item,
-        GdkRectangle     *area);
+        RsttoIconBar *icon_bar,
+        cairo_t      *cr,
+        gint          idx);
+
+static GdkPixbuf *
+rstto_icon_bar_get_placeholder (
+        RsttoIconBar *icon_bar,
+        RsttoFile    *file);
 
 static void
-rstto_icon_bar_calculate_item_size (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item);
+rstto_icon_bar_calculate_item_size (RsttoIconBar *icon_bar);
 
 static void
 rstto_icon_bar_adjustment_changed (
@@ -198,20 +209,43 @@ cb_rstto_thumbnail_size_changed (
         gpointer user_data);
 
 static void
-rstto_icon_bar_update_missing_icon (RsttoIconBar *icon_bar);
+cb_rstto_icon_bar_thumbnail_ready (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *file,
+        guint size,
+        gpointer user_data);
 
+static gboolean
+rstto_icon_bar_get_visible_range (
+        RsttoIconBar *icon_bar,
+        gint         *first,
+        gint         *last);
 
-static RsttoIconBarItem *
-rstto_icon_bar_item_new (void);
+static void
+rstto_icon_bar_update_visible_range (RsttoIconBar *icon_bar);
+
+static gboolean
+cb_rstto_icon_bar_prefetch (gpointer user_data);
 
 static void
-rstto_icon_bar_item_free (RsttoIconBarItem *item);
+rstto_icon_bar_update_missing_icon (RsttoIconBar *icon_bar);
+
+
+static gboolean
+rstto_icon_bar_get_iter (
+        RsttoIconBar *icon_bar,
+        gint          idx,
+        GtkTreeIter  *iter);
 
 static void
-rstto_icon_bar_item_invalidate (RsttoIconBarItem *item);
+rstto_icon_bar_invalidate_window (
+        RsttoIconBar *icon_bar,
+        gint          idx);
 
 static void
-rstto_icon_bar_build_items (RsttoIconBar *icon_bar);
+rstto_icon_bar_queue_draw_from (
+        RsttoIconBar *icon_bar,
+        gint          idx);
 
 static void
 rstto_icon_bar_row_changed (
@@ -241,24 +275,15 @@ rstto_icon_bar_rows_reordered (
         gint         *new_order,
         RsttoIconBar *icon_bar);
 
-struct _RsttoIconBarItem
-{
-    GtkTreeIter iter;
-    gint        index;
-
-    gint        width;
-    gint        height;
-
-    gint        pixbuf_width;
-    gint        pixbuf_height;
-
-    gint        layout_width;
-    gint        layout_height;
-};
-
 struct _RsttoIconBarPrivate
 {
+    /* The bin-window has the size of the visible area, its contents are
+     * moved with gdk_window_scroll. The offset of the contents is the
+     * value of the adjustments at the last scroll.
+     */
     GdkWindow      *bin_window;
+    gint            offset_x;
+    gint            offset_y;
 
     gint            width;
     gint            height;
@@ -266,22 +291,49 @@ struct _RsttoIconBarPrivate
     gint            pixbuf_column;
     gint            file_column;
 
-    RsttoIconBarItem *active_item;
-    RsttoIconBarItem *single_click_item;
-    RsttoIconBarItem *cursor_item;
-
-    GList          *items;
+    /* Indices of the items, -1 if there is none */
+    gint            active;
+    gint            single_click;
+    gint            cursor;
+
+    /* The items are not stored, they follow from their index. Only the
+     * iters of the visible items and a margin around them are cached,
+     * from window_first on.
+     */
+    gint            n_items;
+    GtkTreeIter    *window;
+    gint            window_first;
+    gint            window_size;
+
+    /* Every item has the same size, it only depends on the thumbnail
+     * size and the style. -1 if it has to be calculated.
+     */
+    gint            item_size;
     gint            item_width;
     gint            item_height;
 
+    /* The thumbnails are drawn from an atlas with a slot per item, it is
+     * created when the first item is drawn. NULL if there is none.
+     */
+    RsttoThumbnailAtlas *atlas;
+
     GtkAdjustment  *hadjustment;
     GtkAdjustment  *vadjustment;
 
     RsttoSettings  *settings;
     RsttoThumbnailer *thumbnailer;
+    RsttoThumbnailLoader *thumbnail_loader;
 
     RsttoThumbnailSize thumbnail_size;
 
+    /* Thumbnails outside of the visible range are loaded in advance,
+     * in the direction the icon-bar is scrolled in.
+     */
+    guint           prefetch_id;
+    gint            prefetch_step;
+    gint            scroll_direction;
+    gdouble         scroll_value;
+
     gboolean        auto_center; /* automatically center the active item */
 
     GtkOrientation  orientation;
@@ -501,12 +553,19 @@ rstto_icon_bar_init (RsttoIconBar *icon_bar)
     icon_bar->priv->file_column = -1;
     icon_bar->priv->show_text = TRUE;
     icon_bar->priv->auto_center = TRUE;
+    icon_bar->priv->scroll_direction = 1;
+    icon_bar->priv->item_size = -1;
+    icon_bar->priv->active = -1;
+    icon_bar->priv->single_click = -1;
+    icon_bar->priv->cursor = -1;
     icon_bar->priv->settings = rstto_settings_new ();
     icon_bar->priv->thumbnailer = rstto_thumbnailer_new();
+    icon_bar->priv->thumbnail_loader = rstto_thumbnail_loader_new();
 
     icon_bar->priv->thumbnail_size = rstto_settings_get_uint_property (
             icon_bar->priv->settings,
             "thumbnail-size");
+    rstto_thumbnail_cache_set_size (icon_bar->priv->thumbnail_size);
 
     rstto_icon_bar_update_missing_icon (icon_bar);
 
@@ -526,6 +585,11 @@ rstto_icon_bar_init (RsttoIconBar *icon_bar)
             "notify::thumbnail-size",
             G_CALLBACK (cb_rstto_thumbnail_size_changed),
             icon_bar);
+    g_signal_connect (
+            G_OBJECT(icon_bar->priv->thumbnail_loader),
+            "ready",
+            G_CALLBACK (cb_rstto_icon_bar_thumbnail_ready),
+            icon_bar);
 }
 
 
@@ -547,10 +611,24 @@ rstto_icon_bar_finalize (GObject *object)
 {
     RsttoIconBar *icon_bar = RSTTO_ICON_BAR (object);
 
+    if (icon_bar->priv->prefetch_id != 0)
+        g_source_remove (icon_bar->priv->prefetch_id);
+
+    g_free (icon_bar->priv->window);
+
+    if (icon_bar->priv->atlas != NULL)
+        rstto_thumbnail_atlas_free (icon_bar->priv->atlas);
+
     g_object_unref (G_OBJECT (icon_bar->priv->layout));
     g_object_unref (G_OBJECT (icon_bar->priv->settings));
     g_object_unref (G_OBJECT (icon_bar->priv->thumbnailer));
 
+    g_signal_handlers_disconnect_by_func (
+            icon_bar->priv->thumbnail_loader,
+            cb_rstto_icon_bar_thumbnail_ready,
+            icon_bar);
+    g_object_unref (G_OBJECT (icon_bar->priv->thumbnail_loader));
+
     (*G_OBJECT_CLASS (rstto_icon_bar_parent_class)->finalize) (object);
 }
 
@@ -643,6 +721,9 @@ rstto_icon_bar_style_set (
 
     (*GTK_WIDGET_CLASS (rstto_icon_bar_parent_class)->style_set) (widget, previous_style);
 
+    /* The focus-line is part of the item size */
+    rstto_icon_bar_invalidate (icon_bar);
+
     if (GTK_WIDGET_REALIZED (widget))
     {
         gdk_window_set_background (icon_bar->priv->bin_window,
@@ -678,8 +759,8 @@ rstto_icon_bar_realize (GtkWidget *widget)
 
     attributes.x = 0;
     attributes.y = 0;
-    attributes.width = MAX (icon_bar->priv->width, widget->allocation.width);
-    attributes.height = MAX (icon_bar->priv->height, widget->allocation.height);
+    attributes.width = widget->allocation.width;
+    attributes.height = widget->allocation.height;
     attributes.event_mask = (GDK_SCROLL_MASK
             | GDK_EXPOSURE_MASK
             | GDK_LEAVE_NOTIFY_MASK
@@ -695,6 +776,9 @@ rstto_icon_bar_realize (GtkWidget *widget)
             &attributes, attributes_mask);
     gdk_window_set_user_data (icon_bar->priv->bin_window, widget);
 
+    icon_bar->priv->offset_x = icon_bar->priv->hadjustment->value;
+    icon_bar->priv->offset_y = icon_bar->priv->vadjustment->value;
+
     widget->style = gtk_style_attach (widget->style, widget->window);
     gdk_window_set_background (widget->window, &widget->style->base[widget->state]);
     gdk_window_set_background (icon_bar->priv->bin_window, &widget->style->base[widget->state]);
@@ -712,6 +796,13 @@ rstto_icon_bar_unrealize (GtkWidget *widget)
     gdk_window_destroy (icon_bar->priv->bin_window);
     icon_bar->priv->bin_window = NULL;
 
+    /* The pages of the atlas are similar to the bin-window */
+    if (icon_bar->priv->atlas != NULL)
+    {
+        rstto_thumbnail_atlas_free (icon_bar->priv->atlas);
+        icon_bar->priv->atlas = NULL;
+    }
+
     /* GtkWidget::unrealize destroys children and widget->window */
     (*GTK_WIDGET_CLASS (rstto_icon_bar_parent_class)->unrealize) (widget);
 }
@@ -723,34 +814,23 @@ rstto_icon_bar_size_request (
         GtkWidget      *widget,
         GtkRequisition *requisition)
 {
-    RsttoIconBarItem *item;
     RsttoIconBar     *icon_bar = RSTTO_ICON_BAR (widget);
-    GList          *lp;
-    gint            n = 0;
-    gint            max_width = 0;
-    gint            max_height = 0;
+    gint            n;
 
     if (!RSTTO_ICON_BAR_VALID_MODEL_AND_COLUMNS (icon_bar)
-            || icon_bar->priv->items == NULL)
+            || icon_bar->priv->n_items == 0)
     {
         icon_bar->priv->width = requisition->width = 0;
         icon_bar->priv->height = requisition->height = 0;
         return;
     }
 
-    /* calculate max item size */
-    for (lp = icon_bar->priv->items; lp != NULL; ++n, lp = lp->next)
-    {
-        item = lp->data;
-        rstto_icon_bar_calculate_item_size (icon_bar, item);
-        if (item->width > max_width)
-            max_width = item->width;
-        if (item->height > max_height)
-            max_height = item->height;
-    }
+    /* The items do not have to be measured, they have the same size */
+    rstto_icon_bar_calculate_item_size (icon_bar);
+    n = icon_bar->priv->n_items;
 
-    icon_bar->priv->item_width = max_width;
-    icon_bar->priv->item_height = max_height;
+    icon_bar->priv->item_width = icon_bar->priv->item_size;
+    icon_bar->priv->item_height = icon_bar->priv->item_size;
 
     if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
     {
@@ -777,7 +857,7 @@ rstto_icon_bar_size_allocate (
 
     widget->allocation = *allocation;
 
-    if (!icon_bar->priv->active_item)
+    if (icon_bar->priv->active < 0)
         g_warning ("thumbnail bar shown when no images are available");
 
     if (GTK_WIDGET_REALIZED (widget))
@@ -788,8 +868,8 @@ rstto_icon_bar_size_allocate (
                 allocation->width,
                 allocation->height);
         gdk_window_resize (icon_bar->priv->bin_window,
-                MAX (icon_bar->priv->width, allocation->width),
-                MAX (icon_bar->priv->height, allocation->height));
+                allocation->width,
+                allocation->height);
     }
 
     if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
@@ -827,9 +907,9 @@ rstto_icon_bar_size_allocate (
         /* If auto-center is true, center the selected item */
         if (icon_bar->priv->auto_center == TRUE)
         {
-            if (icon_bar->priv->active_item)
+            if (icon_bar->priv->active >= 0)
             {
-                value = icon_bar->priv->active_item->index * icon_bar->priv->item_height;// - ((page_size-icon_bar->priv->item_height)/2);
+                value = icon_bar->priv->active * icon_bar->priv->item_height;// - ((page_size-icon_bar->priv->item_height)/2);
             }
 		
 
@@ -862,7 +942,7 @@ rstto_icon_bar_size_allocate (
         /* If auto-center is true, center the selected item */
         if (icon_bar->priv->auto_center == TRUE)
         {
-            value = icon_bar->priv->active_item->index * icon_bar->priv->item_width - ((page_size-icon_bar->priv->item_width)/2);
+            value = icon_bar->priv->active * icon_bar->priv->item_width - ((page_size-icon_bar->priv->item_width)/2);
 
             if (value > (gtk_adjustment_get_upper (icon_bar->priv->hadjustment)-page_size))
                 value = (gtk_adjustment_get_upper (icon_bar->priv->hadjustment)-page_size);
@@ -882,6 +962,8 @@ rstto_icon_bar_size_allocate (
             rstto_icon_bar_adjustment_changed (icon_bar, icon_bar->priv->hadjustment);
         }
     }
+
+    rstto_icon_bar_update_visible_range (icon_bar);
 }
 
 
@@ -891,50 +973,69 @@ rstto_icon_bar_expose (
         GtkWidget      *widget,
         GdkEventExpose *expose)
 {
-    RsttoIconBarItem *item;
     GdkRectangle    area;
     RsttoIconBar     *icon_bar = RSTTO_ICON_BAR (widget);
-    GList          *lp;
-    RsttoFile      *file;
-    GtkTreeIter     iter;
+    cairo_t        *cr;
+    gint            item_size;
+    gint            first, last;
+    gint            n;
 
     if (expose->window != icon_bar->priv->bin_window)
         return FALSE;
 
-    for (lp = icon_bar->priv->items; lp != NULL; lp = lp->next)
+    /* The items have a uniform size, the exposed slice follows from the
+     * expose-area without testing every item. After a scroll, only the
+     * strip that was scrolled into view is exposed.
+     */
+    if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
     {
-        item = lp->data;
+        item_size = icon_bar->priv->item_height;
+        if (item_size <= 0)
+            return TRUE;
 
+        first = (expose->area.y + icon_bar->priv->offset_y) / item_size;
+        last = (expose->area.y + icon_bar->priv->offset_y + expose->area.height - 1) / item_size;
+    }
+    else
+    {
+        item_size = icon_bar->priv->item_width;
+        if (item_size <= 0)
+            return TRUE;
+
+        first = (expose->area.x + icon_bar->priv->offset_x) / item_size;
+        last = (expose->area.x + icon_bar->priv->offset_x + expose->area.width - 1) / item_size;
+    }
+
+    cr = gdk_cairo_create (icon_bar->priv->bin_window);
+    gdk_cairo_region (cr, expose->region);
+    cairo_clip (cr);
+
+    last = MIN (last, icon_bar->priv->n_items - 1);
+    for (n = MAX (first, 0); n <= last; ++n)
+    {
         if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
         {
-            area.x = 0;
-            area.y = item->index * icon_bar->priv->item_height;
+            area.x = -icon_bar->priv->offset_x;
+            area.y = n * icon_bar->priv->item_height - icon_bar->priv->offset_y;
         }
         else
         {
-            area.x = item->index * icon_bar->priv->item_width;
-            area.y = 0;
+            area.x = n * icon_bar->priv->item_width - icon_bar->priv->offset_x;
+            area.y = -icon_bar->priv->offset_y;
         }
 
         area.width = icon_bar->priv->item_width;
         area.height = icon_bar->priv->item_height;
 
-
+        /* The region may consist of several rectangles */
         if (gdk_region_rect_in (expose->region, &area) != GDK_OVERLAP_RECTANGLE_OUT)
         {
-            rstto_icon_bar_paint_item (icon_bar, item, &expose->area);
-        }
-        else
-        {
-            iter = item->iter;
-            gtk_tree_model_get (icon_bar->priv->model, &iter,
-                    icon_bar->priv->file_column, &file,
-                    -1);
-            rstto_thumbnailer_dequeue_file (icon_bar->priv->thumbnailer, file);
-            g_object_unref (file);
+            rstto_icon_bar_paint_item (icon_bar, cr, n);
         }
     }
 
+    cairo_destroy (cr);
+
     return TRUE;
 }
 
@@ -947,10 +1048,10 @@ rstto_icon_bar_leave (
 {
     RsttoIconBar *icon_bar = RSTTO_ICON_BAR (widget);
 
-    if (icon_bar->priv->cursor_item != NULL)
+    if (icon_bar->priv->cursor >= 0)
     {
-        rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor_item);
-        icon_bar->priv->cursor_item = NULL;
+        rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor);
+        icon_bar->priv->cursor = -1;
     }
 
     return FALSE;
@@ -963,32 +1064,24 @@ rstto_icon_bar_motion (
         GtkWidget      *widget,
         GdkEventMotion *event)
 {
-    RsttoIconBarItem *item;
     RsttoIconBar     *icon_bar = RSTTO_ICON_BAR (widget);
-    GtkTreeIter       iter;
-    RsttoFile        *file;
+    gint              idx;
 
-    item = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
-    if (item != NULL && icon_bar->priv->cursor_item != item)
+    idx = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
+    if (idx >= 0 && icon_bar->priv->cursor != idx)
     {
-        if (icon_bar->priv->cursor_item != NULL)
-            rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor_item);
-        icon_bar->priv->cursor_item = item;
-        rstto_icon_bar_queue_draw_item (icon_bar, item);
-
-        iter = item->iter;
-        gtk_tree_model_get (icon_bar->priv->model, &iter,
-                icon_bar->priv->file_column, &file,
-                -1);
-        g_object_unref (file);
+        if (icon_bar->priv->cursor >= 0)
+            rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor);
+        icon_bar->priv->cursor = idx;
+        rstto_icon_bar_queue_draw_item (icon_bar, idx);
 
         gtk_widget_trigger_tooltip_query (widget);
     }
-    else if (icon_bar->priv->cursor_item != NULL
-            && icon_bar->priv->cursor_item != item)
+    else if (icon_bar->priv->cursor >= 0
+            && icon_bar->priv->cursor != idx)
     {
-        rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor_item);
-        icon_bar->priv->cursor_item = NULL;
+        rstto_icon_bar_queue_draw_item (icon_bar, icon_bar->priv->cursor);
+        icon_bar->priv->cursor = -1;
     }
 
     return TRUE;
@@ -1042,7 +1135,6 @@ rstto_icon_bar_button_press (
         GdkEventButton *event)
 {
     RsttoIconBar *icon_bar;
-    RsttoIconBarItem *item;
 
     icon_bar = RSTTO_ICON_BAR (widget);
 
@@ -1051,8 +1143,7 @@ rstto_icon_bar_button_press (
 
     if (event->button == 1 && event->type == GDK_BUTTON_PRESS)
     {
-        item = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
-        icon_bar->priv->single_click_item = item;
+        icon_bar->priv->single_click = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
     }
     return TRUE;
 }
@@ -1063,15 +1154,15 @@ rstto_icon_bar_button_release (
         GdkEventButton *event)
 {
     RsttoIconBar *icon_bar;
-    RsttoIconBarItem *item;
+    gint          idx;
 
     icon_bar = RSTTO_ICON_BAR (widget);
 
     if (event->button == 1 && event->type == GDK_BUTTON_RELEASE)
     {
-        item = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
-        if (G_LIKELY (item != NULL && item != icon_bar->priv->active_item && item == icon_bar->priv->single_click_item))
-            rstto_icon_bar_set_active (icon_bar, item->index);
+        idx = rstto_icon_bar_get_item_at_pos (icon_bar, event->x, event->y);
+        if (G_LIKELY (idx >= 0 && idx != icon_bar->priv->active && idx == icon_bar->priv->single_click))
+            rstto_icon_bar_set_active (icon_bar, idx);
     }
     return TRUE;
 }
@@ -1142,6 +1233,8 @@ cb_rstto_icon_bar_adjustment_value_changed (
         GtkAdjustment *adjustment,
         RsttoIconBar  *icon_bar)
 {
+    gint dx, dy;
+
     if (GTK_WIDGET_REALIZED (icon_bar))
     {
         /* Set auto_center to false, this should be the default behaviour
@@ -1153,9 +1246,18 @@ cb_rstto_icon_bar_adjustment_value_changed (
          */
         icon_bar->priv->auto_center = FALSE;
 
-        gdk_window_move (icon_bar->priv->bin_window,
-                - icon_bar->priv->hadjustment->value,
-                - icon_bar->priv->vadjustment->value);
+        /* Move the pixels that stay visible, only the items that are
+         * scrolled into view are exposed.
+         */
+        dx = icon_bar->priv->offset_x - (gint) icon_bar->priv->hadjustment->value;
+        dy = icon_bar->priv->offset_y - (gint) icon_bar->priv->vadjustment->value;
+        icon_bar->priv->offset_x -= dx;
+        icon_bar->priv->offset_y -= dy;
+
+        if (dx != 0 || dy != 0)
+            gdk_window_scroll (icon_bar->priv->bin_window, dx, dy);
+
+        rstto_icon_bar_update_visible_range (icon_bar);
 
         gdk_window_process_updates (icon_bar->priv->bin_window, TRUE);
     }
@@ -1164,36 +1266,55 @@ cb_rstto_icon_bar_adjustment_value_changed (
 static void
 rstto_icon_bar_invalidate (RsttoIconBar *icon_bar)
 {
-    g_list_foreach (icon_bar->priv->items, (GFunc) rstto_icon_bar_item_invalidate, NULL);
+    icon_bar->priv->item_size = -1;
+
+    if (icon_bar->priv->atlas != NULL)
+    {
+        rstto_thumbnail_atlas_free (icon_bar->priv->atlas);
+        icon_bar->priv->atlas = NULL;
+    }
 
     gtk_widget_queue_resize (GTK_WIDGET (icon_bar));
+    gtk_widget_queue_draw (GTK_WIDGET (icon_bar));
 }
 
-static RsttoIconBarItem*
+/**
+ * rstto_icon_bar_get_item_at_pos:
+ * @icon_bar : A #RsttoIconBar.
+ * @x        : X-coordinate in the bin-window, not in the scrolled contents.
+ * @y        : Y-coordinate in the bin-window, not in the scrolled contents.
+ *
+ * Returns: The index of the item at @x, @y or -1.
+ **/
+static gint
 rstto_icon_bar_get_item_at_pos (
         RsttoIconBar *icon_bar,
         gint          x,
         gint          y)
 {
-    GList *lp;
+    gint idx;
 
-    if (G_UNLIKELY (icon_bar->priv->item_height == 0))
-        return NULL;
+    x += icon_bar->priv->offset_x;
+    y += icon_bar->priv->offset_y;
+
+    if (G_UNLIKELY (icon_bar->priv->item_height <= 0 || icon_bar->priv->item_width <= 0)
+            || x < 0 || y < 0)
+        return -1;
 
     if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
-        lp = g_list_nth (icon_bar->priv->items, y / icon_bar->priv->item_height);
+        idx = y / icon_bar->priv->item_height;
     else
-        lp = g_list_nth (icon_bar->priv->items, x / icon_bar->priv->item_width);
+        idx = x / icon_bar->priv->item_width;
 
-    return (lp != NULL) ? lp->data : NULL;
+    return (idx < icon_bar->priv->n_items) ? idx : -1;
 }
 
 
 
 static void
 rstto_icon_bar_queue_draw_item (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item)
+        RsttoIconBar *icon_bar,
+        gint          idx)
 {
     GdkRectangle area;
 
@@ -1201,13 +1322,13 @@ rstto_icon_bar_queue_draw_item (
     {
         if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
         {
-            area.x = 0;
-            area.y = icon_bar->priv->item_height * item->index;
+            area.x = -icon_bar->priv->offset_x;
+            area.y = icon_bar->priv->item_height * idx - icon_bar->priv->offset_y;
         }
         else
         {
-            area.x = icon_bar->priv->item_width * item->index;
-            area.y = 0;
+            area.x = icon_bar->priv->item_width * idx - icon_bar->priv->offset_x;
+            area.y = -icon_bar->priv->offset_y;
         }
 
         area.width = icon_bar->priv->item_width;
@@ -1221,23 +1342,26 @@ rstto_icon_bar_queue_draw_item (
 
 static void
 rstto_icon_bar_paint_item (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item,
-        GdkRectangle     *area)
+        RsttoIconBar *icon_bar,
+        cairo_t      *cr,
+        gint          idx)
 {
     const GdkPixbuf *pixbuf = NULL;
+    GdkPixbuf       *placeholder = NULL;
     GdkColor        *border_color;
     GdkColor        *fill_color;
-    GdkGC           *gc;
     gint             focus_width;
     gint             focus_pad;
     gint             x, y;
     gint             px, py;
     gint             pixbuf_height, pixbuf_width;
+    cairo_surface_t *page = NULL;
+    gint             slot_x = 0, slot_y = 0;
     RsttoFile       *file;
     GtkTreeIter      iter;
 
-    if (!RSTTO_ICON_BAR_VALID_MODEL_AND_COLUMNS (icon_bar))
+    if (!RSTTO_ICON_BAR_VALID_MODEL_AND_COLUMNS (icon_bar) ||
+        !rstto_icon_bar_get_iter (icon_bar, idx, &iter))
         return;
 
     gtk_widget_style_get (GTK_WIDGET (icon_bar),
@@ -1245,13 +1369,24 @@ rstto_icon_bar_paint_item (
             "focus-padding", &focus_pad,
             NULL);
 
-    iter = item->iter;
     gtk_tree_model_get (icon_bar->priv->model, &iter,
             icon_bar->priv->file_column, &file,
             -1);
     
     pixbuf = rstto_file_get_thumbnail (file, icon_bar->priv->thumbnail_size);
 
+    if (NULL == pixbuf)
+    {
+        /* Requests close to the visible items go first */
+        rstto_thumbnailer_set_position (icon_bar->priv->thumbnailer, file, idx);
+
+        /* The thumbnail is being loaded, scale another size in the
+         * meantime if there is one.
+         */
+        placeholder = rstto_icon_bar_get_placeholder (icon_bar, file);
+        pixbuf = placeholder;
+    }
+
     g_object_unref (file);
 
     if (NULL == pixbuf)
@@ -1265,25 +1400,24 @@ rstto_icon_bar_paint_item (
         pixbuf_height = gdk_pixbuf_get_height (pixbuf);
     }
 
-    /* calculate pixbuf/layout location */
+    /* calculate pixbuf/layout location, relative to the scrolled contents */
     if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
     {
         x = 0;
-        y = icon_bar->priv->item_height * item->index;
-
-        px = (icon_bar->priv->item_width - pixbuf_width) / 2;
-        py = (icon_bar->priv->item_height - pixbuf_height) / 2 + icon_bar->priv->item_height * item->index;
+        y = icon_bar->priv->item_height * idx;
     }
     else
     {
-        x = icon_bar->priv->item_width * item->index;
+        x = icon_bar->priv->item_width * idx;
         y = 0;
-
-        px = (icon_bar->priv->item_width - pixbuf_width) / 2 + icon_bar->priv->item_width * item->index;
-        py = (icon_bar->priv->item_height - pixbuf_height) / 2;
     }
 
-    if (icon_bar->priv->active_item == item)
+    x -= icon_bar->priv->offset_x;
+    y -= icon_bar->priv->offset_y;
+    px = x + (icon_bar->priv->item_width - pixbuf_width) / 2;
+    py = y + (icon_bar->priv->item_height - pixbuf_height) / 2;
+
+    if (icon_bar->priv->active == idx)
     {
         gtk_widget_style_get (GTK_WIDGET (icon_bar),
                 "active-item-fill-color", &fill_color,
@@ -1302,26 +1436,25 @@ rstto_icon_bar_paint_item (
             gdk_color_parse ("#316ac5", border_color);
         }
 
-        gc = gdk_gc_new (icon_bar->priv->bin_window);
-        gdk_gc_set_clip_rectangle (gc, area);
-        gdk_gc_set_rgb_fg_color (gc, fill_color);
-        gdk_draw_rectangle (icon_bar->priv->bin_window, gc, TRUE,
+        gdk_cairo_set_source_color (cr, fill_color);
+        cairo_rectangle (cr,
                 x + focus_pad + focus_width,
                 y + focus_pad + focus_width,
                 icon_bar->priv->item_width - 2 * (focus_width + focus_pad),
                 icon_bar->priv->item_height - 2 * (focus_width + focus_pad));
-        gdk_gc_set_rgb_fg_color (gc, border_color);
-        gdk_gc_set_line_attributes (gc, focus_width, GDK_LINE_SOLID, GDK_CAP_BUTT, GDK_JOIN_MITER);
-        gdk_draw_rectangle (icon_bar->priv->bin_window, gc, FALSE,
-                x + focus_pad + focus_width / 2,
-                y + focus_pad + focus_width / 2,
+        cairo_fill (cr);
+        gdk_cairo_set_source_color (cr, border_color);
+        cairo_set_line_width (cr, focus_width);
+        cairo_rectangle (cr,
+                x + focus_pad + focus_width / 2.0,
+                y + focus_pad + focus_width / 2.0,
                 icon_bar->priv->item_width - (2 * focus_pad + focus_width),
                 icon_bar->priv->item_height - (2 * focus_pad + focus_width));
+        cairo_stroke (cr);
         gdk_color_free (border_color);
         gdk_color_free (fill_color);
-        g_object_unref (gc);
     }
-    else if (icon_bar->priv->cursor_item == item)
+    else if (icon_bar->priv->cursor == idx)
     {
         gtk_widget_style_get (GTK_WIDGET (icon_bar),
                 "cursor-item-fill-color", &fill_color,
@@ -1340,49 +1473,143 @@ rstto_icon_bar_paint_item (
             gdk_color_parse ("#98b4e2", border_color);
         }
 
-        gc = gdk_gc_new (icon_bar->priv->bin_window);
-        gdk_gc_set_clip_rectangle (gc, area);
-        gdk_gc_set_rgb_fg_color (gc, fill_color);
-        gdk_draw_rectangle (icon_bar->priv->bin_window, gc, TRUE,
+        gdk_cairo_set_source_color (cr, fill_color);
+        cairo_rectangle (cr,
                 x + focus_pad + focus_width,
                 y + focus_pad + focus_width,
                 icon_bar->priv->item_width - 2 * (focus_width + focus_pad),
                 icon_bar->priv->item_height - 2 * (focus_width + focus_pad));
-        gdk_gc_set_rgb_fg_color (gc, border_color);
-        gdk_gc_set_line_attributes (gc, focus_width, GDK_LINE_SOLID, GDK_CAP_BUTT, GDK_JOIN_MITER);
-        gdk_draw_rectangle (icon_bar->priv->bin_window, gc, FALSE,
-                x + focus_pad + focus_width / 2,
-                y + focus_pad + focus_width / 2,
+        cairo_fill (cr);
+        gdk_cairo_set_source_color (cr, border_color);
+        cairo_set_line_width (cr, focus_width);
+        cairo_rectangle (cr,
+                x + focus_pad + focus_width / 2.0,
+                y + focus_pad + focus_width / 2.0,
                 icon_bar->priv->item_width - (2 * focus_pad + focus_width),
                 icon_bar->priv->item_height - (2 * focus_pad + focus_width));
+        cairo_stroke (cr);
         gdk_color_free (border_color);
         gdk_color_free (fill_color);
-        g_object_unref (gc);
     }
 
 
     if (NULL != pixbuf)
     {
-        gdk_draw_pixbuf (icon_bar->priv->bin_window, NULL, pixbuf, 0, 0,
-                px, py, 
-                pixbuf_width, pixbuf_height,
-                GDK_RGB_DITHER_NORMAL,
-                pixbuf_width, pixbuf_height);
+        /* A placeholder is only drawn once, it is not worth a slot. The
+         * item-size is not known between rstto_icon_bar_invalidate and
+         * the next size-request, the pixbuf is drawn directly then.
+         */
+        if (NULL == placeholder && icon_bar->priv->item_size > 0)
+        {
+            if (icon_bar->priv->atlas == NULL)
+                icon_bar->priv->atlas = rstto_thumbnail_atlas_new (icon_bar->priv->item_size);
+
+            if (icon_bar->priv->atlas != NULL)
+                page = rstto_thumbnail_atlas_lookup (
+                        icon_bar->priv->atlas,
+                        cr,
+                        (GdkPixbuf *) pixbuf,
+                        &slot_x,
+                        &slot_y);
+        }
+
+        if (NULL != page)
+            cairo_set_source_surface (cr, page, px - slot_x, py - slot_y);
+        else
+            gdk_cairo_set_source_pixbuf (cr, pixbuf, px, py);
+
+        cairo_rectangle (cr, px, py, pixbuf_width, pixbuf_height);
+        cairo_fill (cr);
+    }
+
+    if (NULL != placeholder)
+    {
+        g_object_unref (placeholder);
+    }
+}
+
+
+
+/**
+ * rstto_icon_bar_get_placeholder:
+ * @icon_bar : A #RsttoIconBar.
+ * @file     : A #RsttoFile.
+ *
+ * Scales the nearest thumbnail-size of @file that is already in memory to
+ * the current thumbnail-size. The scaled up smaller sizes look blurred, which
+ * is good enough until the real thumbnail is loaded.
+ *
+ * Return value: a new #GdkPixbuf, or %NULL if there is no other size.
+ **/
+static GdkPixbuf *
+rstto_icon_bar_get_placeholder (
+        RsttoIconBar *icon_bar,
+        RsttoFile    *file)
+{
+    const GdkPixbuf *pixbuf = NULL;
+    gint             size = icon_bar->priv->thumbnail_size;
+    gint             i;
+    gint             width, height;
+    gint             max_size;
+    gdouble          scale;
+
+    for (i = 1; (pixbuf == NULL) && (i < THUMBNAIL_SIZE_COUNT); ++i)
+    {
+        if (size - i >= 0)
+            pixbuf = rstto_file_peek_thumbnail (file, size - i);
+        if (pixbuf == NULL && size + i < THUMBNAIL_SIZE_COUNT)
+            pixbuf = rstto_file_peek_thumbnail (file, size + i);
+    }
+
+    if (pixbuf == NULL)
+        return NULL;
+
+    switch (icon_bar->priv->thumbnail_size)
+    {
+        case THUMBNAIL_SIZE_VERY_SMALL:
+            max_size = THUMBNAIL_SIZE_VERY_SMALL_SIZE;
+            break;
+        case THUMBNAIL_SIZE_SMALLER:
+            max_size = THUMBNAIL_SIZE_SMALLER_SIZE;
+            break;
+        case THUMBNAIL_SIZE_SMALL:
+            max_size = THUMBNAIL_SIZE_SMALL_SIZE;
+            break;
+        case THUMBNAIL_SIZE_NORMAL:
+            max_size = THUMBNAIL_SIZE_NORMAL_SIZE;
+            break;
+        case THUMBNAIL_SIZE_LARGE:
+            max_size = THUMBNAIL_SIZE_LARGE_SIZE;
+            break;
+        case THUMBNAIL_SIZE_LARGER:
+            max_size = THUMBNAIL_SIZE_LARGER_SIZE;
+            break;
+        case THUMBNAIL_SIZE_VERY_LARGE:
+        default:
+            max_size = THUMBNAIL_SIZE_VERY_LARGE_SIZE;
+            break;
     }
+
+    width = gdk_pixbuf_get_width (pixbuf);
+    height = gdk_pixbuf_get_height (pixbuf);
+    scale = (gdouble) max_size / MAX (width, height);
+
+    return gdk_pixbuf_scale_simple (pixbuf,
+            MAX (1, width * scale),
+            MAX (1, height * scale),
+            GDK_INTERP_BILINEAR);
 }
 
 
 
 static void
-rstto_icon_bar_calculate_item_size (
-        RsttoIconBar     *icon_bar,
-        RsttoIconBarItem *item)
+rstto_icon_bar_calculate_item_size (RsttoIconBar *icon_bar)
 {
     gint       focus_width;
     gint       focus_pad;
     gint       int_pad;
 
-    if (G_LIKELY (item->width != -1))
+    if (G_LIKELY (icon_bar->priv->item_size != -1))
         return;
 
     gtk_widget_style_get (GTK_WIDGET (icon_bar),
@@ -1394,90 +1621,158 @@ rstto_icon_bar_calculate_item_size (
     switch (icon_bar->priv->thumbnail_size)
     {
         case THUMBNAIL_SIZE_VERY_SMALL:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_VERY_SMALL_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_VERY_SMALL_SIZE;
             break;
         case THUMBNAIL_SIZE_SMALLER:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_SMALLER_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_SMALLER_SIZE;
             break;
         case THUMBNAIL_SIZE_SMALL:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_SMALL_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_SMALL_SIZE;
             break;
         case THUMBNAIL_SIZE_NORMAL:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_NORMAL_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_NORMAL_SIZE;
             break;
         case THUMBNAIL_SIZE_LARGE:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_LARGE_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_LARGE_SIZE;
             break;
         case THUMBNAIL_SIZE_LARGER:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_LARGER_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_LARGER_SIZE;
             break;
         case THUMBNAIL_SIZE_VERY_LARGE:
-            item->width = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_VERY_LARGE_SIZE;
+            icon_bar->priv->item_size = (2 * (int_pad + focus_width + focus_pad)) + THUMBNAIL_SIZE_VERY_LARGE_SIZE;
             break;
         default:
+            icon_bar->priv->item_size = 0;
             break;
     }
-
-    item->height = item->width;
 }
 
-static RsttoIconBarItem *
-rstto_icon_bar_item_new (void)
+/**
+ * rstto_icon_bar_get_iter:
+ * @icon_bar : A #RsttoIconBar.
+ * @idx      : The index of an item.
+ * @iter     : Return location for the iter of the item.
+ *
+ * The iters of the visible items are cached, the cache is refilled when
+ * an item outside of it is drawn. Other items are looked up in the model.
+ *
+ * Returns: %FALSE if @idx is out of range.
+ **/
+static gboolean
+rstto_icon_bar_get_iter (
+        RsttoIconBar *icon_bar,
+        gint          idx,
+        GtkTreeIter  *iter)
 {
-    RsttoIconBarItem *item;
+    GtkTreePath *path;
+    gint         first, last;
+    gint         n;
 
-    item = g_slice_new0 (RsttoIconBarItem);
-    item->width = -1;
-    item->height = -1;
+    if (idx < 0 || idx >= icon_bar->priv->n_items)
+        return FALSE;
 
-    return item;
-}
+    if (idx >= icon_bar->priv->window_first
+            && idx < icon_bar->priv->window_first + icon_bar->priv->window_size)
+    {
+        *iter = icon_bar->priv->window[idx - icon_bar->priv->window_first];
+        return TRUE;
+    }
 
+    if (rstto_icon_bar_get_visible_range (icon_bar, &first, &last)
+            && idx >= first - RSTTO_ICON_BAR_WINDOW_MARGIN
+            && idx <= last + RSTTO_ICON_BAR_WINDOW_MARGIN)
+    {
+        first = MAX (0, first - RSTTO_ICON_BAR_WINDOW_MARGIN);
+        last = MIN (icon_bar->priv->n_items - 1, last + RSTTO_ICON_BAR_WINDOW_MARGIN);
 
+        icon_bar->priv->window = g_renew (GtkTreeIter, icon_bar->priv->window, last - first + 1);
+        icon_bar->priv->window_first = first;
+        icon_bar->priv->window_size = 0;
 
-static void
-rstto_icon_bar_item_free (RsttoIconBarItem *item)
-{
-    g_slice_free (RsttoIconBarItem, item);
-}
+        path = gtk_tree_path_new_from_indices (first, -1);
+        if (gtk_tree_model_get_iter (icon_bar->priv->model, &icon_bar->priv->window[0], path))
+        {
+            for (n = 1; n <= last - first; ++n)
+            {
+                icon_bar->priv->window[n] = icon_bar->priv->window[n - 1];
+                if (!gtk_tree_model_iter_next (icon_bar->priv->model, &icon_bar->priv->window[n]))
+                    break;
+            }
+            icon_bar->priv->window_size = n;
+        }
+        gtk_tree_path_free (path);
 
+        if (idx < first + icon_bar->priv->window_size)
+        {
+            *iter = icon_bar->priv->window[idx - first];
+            return TRUE;
+        }
+    }
 
+    path = gtk_tree_path_new_from_indices (idx, -1);
+    if (!gtk_tree_model_get_iter (icon_bar->priv->model, iter, path))
+    {
+        gtk_tree_path_free (path);
+        return FALSE;
+    }
+    gtk_tree_path_free (path);
 
-static void
-rstto_icon_bar_item_invalidate (RsttoIconBarItem *item)
-{
-    item->width = -1;
-    item->height = -1;
+    return TRUE;
 }
 
 
 
+/**
+ * rstto_icon_bar_invalidate_window:
+ * @icon_bar : A #RsttoIconBar.
+ * @idx      : Index of the inserted or deleted row.
+ *
+ * An iter may hold the index of its row, the cached iters are stale
+ * when a row before or inside the cache is inserted or deleted. They
+ * are looked up again when the items are drawn.
+ **/
 static void
-rstto_icon_bar_build_items (RsttoIconBar *icon_bar)
+rstto_icon_bar_invalidate_window (
+        RsttoIconBar *icon_bar,
+        gint          idx)
 {
-    RsttoIconBarItem *item;
-    GtkTreeIter     iter;
-    GList          *items = NULL;
-    gint            i = 0;
+    if (idx < icon_bar->priv->window_first + icon_bar->priv->window_size)
+        icon_bar->priv->window_size = 0;
+}
 
-    if (!gtk_tree_model_get_iter_first (icon_bar->priv->model, &iter))
-        return;
 
-    do
-    {
-        item = rstto_icon_bar_item_new ();
-        item->iter = iter;
-        item->index = i++;
 
-        items = g_list_prepend (items, item);
-    }
-    while (gtk_tree_model_iter_next (icon_bar->priv->model, &iter));
+/**
+ * rstto_icon_bar_queue_draw_from:
+ * @icon_bar : A #RsttoIconBar.
+ * @idx      : Index of the inserted or deleted row.
+ *
+ * The scrolled contents are not redrawn when the size changes, the
+ * visible items after @idx moved.
+ **/
+static void
+rstto_icon_bar_queue_draw_from (
+        RsttoIconBar *icon_bar,
+        gint          idx)
+{
+    gint first, last;
 
-    icon_bar->priv->items = g_list_reverse (items);
+    if (GTK_WIDGET_REALIZED (icon_bar)
+            && rstto_icon_bar_get_visible_range (icon_bar, &first, &last)
+            && idx <= last)
+        gtk_widget_queue_draw (GTK_WIDGET (icon_bar));
 }
 
 
 
+/**
+ * rstto_icon_bar_row_changed:
+ *
+ * A changed row does not change the size of its item, only the item is
+ * redrawn. The invalidated areas are collected by GDK and repainted
+ * once per frame, a burst of changed rows is a single repaint. Items
+ * that are not visible are left alone.
+ **/
 static void
 rstto_icon_bar_row_changed (
         GtkTreeModel *model,
@@ -1485,13 +1780,18 @@ rstto_icon_bar_row_changed (
         GtkTreeIter  *iter,
         RsttoIconBar *icon_bar)
 {
-    RsttoIconBarItem  *item;
     gint             idx;
+    gint             first, last;
+
+    if (!GTK_WIDGET_REALIZED (icon_bar) ||
+        !rstto_icon_bar_get_visible_range (icon_bar, &first, &last))
+        return;
 
     idx = gtk_tree_path_get_indices (path)[0];
-    item = g_list_nth (icon_bar->priv->items, idx)->data;
-    rstto_icon_bar_item_invalidate (item);
-    gtk_widget_queue_resize (GTK_WIDGET (icon_bar));
+    if (idx < first || idx > last)
+        return;
+
+    rstto_icon_bar_queue_draw_item (icon_bar, idx);
 }
 
 
@@ -1503,26 +1803,22 @@ rstto_icon_bar_row_inserted (
         GtkTreeIter  *iter,
         RsttoIconBar *icon_bar)
 {
-    RsttoIconBarItem  *item;
-    GList           *lp;
     gint             idx;
 
     idx = gtk_tree_path_get_indices (path)[0];
-    item = rstto_icon_bar_item_new ();
-
-    if ((gtk_tree_model_get_flags (icon_bar->priv->model) & GTK_TREE_MODEL_ITERS_PERSIST) != 0)
-        item->iter = *iter;
-    item->index = idx;
 
-    icon_bar->priv->items = g_list_insert (icon_bar->priv->items, item, idx);
+    icon_bar->priv->n_items++;
+    rstto_icon_bar_invalidate_window (icon_bar, idx);
 
-    for (lp = g_list_nth (icon_bar->priv->items, idx + 1); lp != NULL; lp = lp->next)
-    {
-        item = lp->data;
-        item->index++;
-    }
+    if (icon_bar->priv->active >= idx)
+        icon_bar->priv->active++;
+    if (icon_bar->priv->cursor >= idx)
+        icon_bar->priv->cursor++;
+    if (icon_bar->priv->single_click >= idx)
+        icon_bar->priv->single_click++;
 
     gtk_widget_queue_resize (GTK_WIDGET (icon_bar));
+    rstto_icon_bar_queue_draw_from (icon_bar, idx);
 }
 
 
@@ -1533,41 +1829,33 @@ rstto_icon_bar_row_deleted (
         GtkTreePath  *path,
         RsttoIconBar *icon_bar)
 {
-    RsttoIconBarItem *item;
     gboolean        active = FALSE;
-    GList          *lnext;
-    GList          *lp;
     gint            idx;
 
     g_return_if_fail (RSTTO_IS_ICON_BAR (icon_bar));
 
     idx = gtk_tree_path_get_indices (path)[0];
-    lp = g_list_nth (icon_bar->priv->items, idx);
-    item = lp->data;
-
-    if (item == icon_bar->priv->active_item)
-    {
-        icon_bar->priv->active_item = NULL;
-        active = TRUE;
-    }
-
-    if (item == icon_bar->priv->cursor_item)
-        icon_bar->priv->cursor_item = NULL;
 
-    rstto_icon_bar_item_free (item);
+    icon_bar->priv->n_items--;
+    rstto_icon_bar_invalidate_window (icon_bar, idx);
 
-    for (lnext = lp->next; lnext != NULL; lnext = lnext->next)
-    {
-        item = lnext->data;
-        item->index--;
-    }
+    if (icon_bar->priv->active == idx)
+        active = TRUE;
+    else if (icon_bar->priv->active > idx)
+        icon_bar->priv->active--;
 
-    icon_bar->priv->items = g_list_delete_link (icon_bar->priv->items, lp);
+    if (icon_bar->priv->cursor == idx)
+        icon_bar->priv->cursor = -1;
+    else if (icon_bar->priv->cursor > idx)
+        icon_bar->priv->cursor--;
 
-    if (active && icon_bar->priv->items != NULL)
-        icon_bar->priv->active_item = icon_bar->priv->items->data;
+    if (icon_bar->priv->single_click == idx)
+        icon_bar->priv->single_click = -1;
+    else if (icon_bar->priv->single_click > idx)
+        icon_bar->priv->single_click--;
 
     gtk_widget_queue_resize (GTK_WIDGET (icon_bar));
+    rstto_icon_bar_queue_draw_from (icon_bar, idx);
 
     if (active)
         rstto_icon_bar_set_active (icon_bar, -1);
@@ -1582,32 +1870,27 @@ rstto_icon_bar_rows_reordered (
         gint         *new_order,
         RsttoIconBar *icon_bar)
 {
-    RsttoIconBarItem **item_array;
-    GList           *items = NULL;
-    GList           *lp;
-    gint            *inverted_order;
-    gint             length;
-    gint             i;
+    gint active = -1;
+    gint cursor = -1;
+    gint single_click = -1;
+    gint i;
 
-    length = gtk_tree_model_iter_n_children (model, NULL);
-    inverted_order = g_newa (gint, length);
-
-    /* invert the array */
-    for (i = 0; i < length; ++i)
-        inverted_order[new_order[i]] = i;
-
-    item_array = g_newa (RsttoIconBarItem *, length);
-    for (i = 0, lp = icon_bar->priv->items; lp != NULL; ++i, lp = lp->next)
-        item_array[inverted_order[i]] = lp->data;
-
-    for (i = 0; i < length; ++i)
+    /* new_order[i] is the old index of the item now at i */
+    for (i = 0; i < icon_bar->priv->n_items; ++i)
     {
-        item_array[i]->index = i;
-        items = g_list_append (items, item_array[i]);
+        if (new_order[i] == icon_bar->priv->active)
+            active = i;
+        if (new_order[i] == icon_bar->priv->cursor)
+            cursor = i;
+        if (new_order[i] == icon_bar->priv->single_click)
+            single_click = i;
     }
 
-    g_list_free (icon_bar->priv->items);
-    icon_bar->priv->items = g_list_reverse (items);
+    icon_bar->priv->active = active;
+    icon_bar->priv->cursor = cursor;
+    icon_bar->priv->single_click = single_click;
+    icon_bar->priv->window_size = 0;
+
     if (icon_bar->priv->auto_center)
     {
         rstto_icon_bar_show_active (icon_bar);
@@ -1724,11 +2007,11 @@ rstto_icon_bar_set_model (
 
         g_object_unref (G_OBJECT (icon_bar->priv->model));
 
-        g_list_foreach (icon_bar->priv->items, (GFunc) rstto_icon_bar_item_free, NULL);
-        g_list_free (icon_bar->priv->items);
-        icon_bar->priv->active_item = NULL;
-        icon_bar->priv->cursor_item = NULL;
-        icon_bar->priv->items = NULL;
+        icon_bar->priv->n_items = 0;
+        icon_bar->priv->window_size = 0;
+        icon_bar->priv->active = -1;
+        icon_bar->priv->cursor = -1;
+        icon_bar->priv->single_click = -1;
     }
 
     icon_bar->priv->model = model;
@@ -1746,10 +2029,10 @@ rstto_icon_bar_set_model (
         g_signal_connect (G_OBJECT (model), "rows-reordered",
                 G_CALLBACK (rstto_icon_bar_rows_reordered), icon_bar);
 
-        rstto_icon_bar_build_items (icon_bar);
+        icon_bar->priv->n_items = gtk_tree_model_iter_n_children (model, NULL);
 
-        if (icon_bar->priv->items != NULL)
-            active = ((RsttoIconBarItem *) icon_bar->priv->items->data)->index;
+        if (icon_bar->priv->n_items > 0)
+            active = 0;
     }
 
     rstto_icon_bar_invalidate (icon_bar);
@@ -1856,7 +2139,7 @@ rstto_icon_bar_set_orientation (
     if (icon_bar->priv->orientation != orientation)
     {
         /* Unset the cursor-item */
-        icon_bar->priv->cursor_item = NULL;
+        icon_bar->priv->cursor = -1;
 
         icon_bar->priv->orientation = orientation;
         gtk_widget_queue_resize (GTK_WIDGET (icon_bar));
@@ -1885,9 +2168,7 @@ rstto_icon_bar_get_active (RsttoIconBar *icon_bar)
 {
     g_return_val_if_fail (RSTTO_IS_ICON_BAR (icon_bar), -1);
 
-    return (icon_bar->priv->active_item != NULL)
-        ? icon_bar->priv->active_item->index
-        : -1;
+    return icon_bar->priv->active;
 }
 
 
@@ -1906,16 +2187,14 @@ rstto_icon_bar_set_active (
         gint          idx)
 {
     g_return_if_fail (RSTTO_IS_ICON_BAR (icon_bar));
-    g_return_if_fail (idx == -1 || g_list_nth (icon_bar->priv->items, idx) != NULL);
+    g_return_if_fail (idx >= -1 && idx < icon_bar->priv->n_items);
 
-    if ((icon_bar->priv->active_item == NULL && idx == -1)
-            || (icon_bar->priv->active_item != NULL && idx == icon_bar->priv->active_item->index))
+    if (idx == icon_bar->priv->active)
         return;
 
-    if (G_UNLIKELY (idx >= 0))
-        icon_bar->priv->active_item = g_list_nth (icon_bar->priv->items, idx)->data;
-    else
-        icon_bar->priv->active_item = NULL;
+    icon_bar->priv->active = idx;
+
+    rstto_icon_bar_update_visible_range (icon_bar);
 
     g_signal_emit (G_OBJECT (icon_bar), icon_bar_signals[SELECTION_CHANGED], 0);
     g_object_notify (G_OBJECT (icon_bar), "active");
@@ -1938,28 +2217,13 @@ rstto_icon_bar_get_active_iter (
         RsttoIconBar  *icon_bar,
         GtkTreeIter   *iter)
 {
-    RsttoIconBarItem *item;
-    GtkTreePath    *path;
-
     g_return_val_if_fail (RSTTO_IS_ICON_BAR (icon_bar), FALSE);
     g_return_val_if_fail (iter != NULL, FALSE);
 
-    item = icon_bar->priv->active_item;
-    if (item == NULL)
+    if (icon_bar->priv->active < 0)
         return FALSE;
 
-    if ((gtk_tree_model_get_flags (icon_bar->priv->model) & GTK_TREE_MODEL_ITERS_PERSIST) == 0)
-    {
-        path = gtk_tree_path_new_from_indices (item->index, -1);
-        gtk_tree_model_get_iter (icon_bar->priv->model, iter, path);
-        gtk_tree_path_free (path);
-    }
-    else
-    {
-        *iter = item->iter;
-    }
-
-    return TRUE;
+    return rstto_icon_bar_get_iter (icon_bar, icon_bar->priv->active, iter);
 }
 
 
@@ -2052,7 +2316,7 @@ rstto_icon_bar_show_active (RsttoIconBar *icon_bar)
     gint value = 0;
 
     g_return_val_if_fail (RSTTO_IS_ICON_BAR (icon_bar), FALSE);
-    if (NULL == icon_bar->priv->active_item)
+    if (icon_bar->priv->active < 0)
         return FALSE;
 
     icon_bar->priv->auto_center = TRUE;
@@ -2060,7 +2324,7 @@ rstto_icon_bar_show_active (RsttoIconBar *icon_bar)
     if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
     {
         page_size = gtk_adjustment_get_page_size (icon_bar->priv->vadjustment);
-        value = icon_bar->priv->active_item->index * icon_bar->priv->item_height - ((page_size-icon_bar->priv->item_height)/2);
+        value = icon_bar->priv->active * icon_bar->priv->item_height - ((page_size-icon_bar->priv->item_height)/2);
 
         if (value > (gtk_adjustment_get_upper (icon_bar->priv->vadjustment)-page_size))
             value = (gtk_adjustment_get_upper (icon_bar->priv->vadjustment)-page_size);
@@ -2074,7 +2338,7 @@ rstto_icon_bar_show_active (RsttoIconBar *icon_bar)
     else
     {
         page_size = gtk_adjustment_get_page_size (icon_bar->priv->hadjustment);
-        value = icon_bar->priv->active_item->index * icon_bar->priv->item_width - ((page_size-icon_bar->priv->item_width)/2);
+        value = icon_bar->priv->active * icon_bar->priv->item_width - ((page_size-icon_bar->priv->item_width)/2);
 
         if (value > (gtk_adjustment_get_upper (icon_bar->priv->hadjustment)-page_size))
             value = (gtk_adjustment_get_upper (icon_bar->priv->hadjustment)-page_size);
@@ -2139,6 +2403,7 @@ cb_rstto_thumbnail_size_changed (
 
 
     icon_bar->priv->thumbnail_size = g_value_get_uint (&val_thumbnail_size);
+    rstto_thumbnail_cache_set_size (icon_bar->priv->thumbnail_size);
 
     rstto_icon_bar_invalidate (icon_bar);
 
@@ -2147,6 +2412,232 @@ cb_rstto_thumbnail_size_changed (
 }
 
 
+/**
+ * rstto_icon_bar_get_visible_range:
+ * @icon_bar : A #RsttoIconBar.
+ * @first    : Return location for the index of the first visible item.
+ * @last     : Return location for the index of the last visible item.
+ *
+ * Return value: %FALSE if the size of the items is not known yet.
+ **/
+static gboolean
+rstto_icon_bar_get_visible_range (
+        RsttoIconBar *icon_bar,
+        gint         *first,
+        gint         *last)
+{
+    GtkAdjustment *adjustment;
+    gint           item_size;
+
+    if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
+    {
+        adjustment = icon_bar->priv->vadjustment;
+        item_size = icon_bar->priv->item_height;
+    }
+    else
+    {
+        adjustment = icon_bar->priv->hadjustment;
+        item_size = icon_bar->priv->item_width;
+    }
+
+    if (adjustment == NULL || item_size <= 0)
+        return FALSE;
+
+    *first = adjustment->value / item_size;
+    *last = (adjustment->value + adjustment->page_size) / item_size;
+
+    return TRUE;
+}
+
+
+
+/**
+ * rstto_icon_bar_update_visible_range:
+ * @icon_bar : A #RsttoIconBar.
+ *
+ * Tells the thumbnailer which items are visible, the thumbnails of those
+ * items are requested first. The thumbnails of the items next to them
+ * are prefetched when the main loop is idle.
+ **/
+static void
+rstto_icon_bar_update_visible_range (RsttoIconBar *icon_bar)
+{
+    gdouble value;
+    gint    first, last;
+
+    if (!GTK_WIDGET_REALIZED (icon_bar) ||
+        !rstto_icon_bar_get_visible_range (icon_bar, &first, &last))
+        return;
+
+    rstto_thumbnailer_set_visible_range (
+            icon_bar->priv->thumbnailer,
+            first,
+            last,
+            icon_bar->priv->active);
+
+    if (icon_bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
+        value = icon_bar->priv->vadjustment->value;
+    else
+        value = icon_bar->priv->hadjustment->value;
+
+    if (value > icon_bar->priv->scroll_value)
+        icon_bar->priv->scroll_direction = 1;
+    else if (value < icon_bar->priv->scroll_value)
+        icon_bar->priv->scroll_direction = -1;
+    icon_bar->priv->scroll_value = value;
+
+    if (icon_bar->priv->prefetch_id != 0)
+        g_source_remove (icon_bar->priv->prefetch_id);
+
+    icon_bar->priv->prefetch_step = 0;
+    icon_bar->priv->prefetch_id = g_idle_add_full (
+            G_PRIORITY_DEFAULT_IDLE,
+            cb_rstto_icon_bar_prefetch,
+            icon_bar,
+            NULL);
+}
+
+
+
+/**
+ * cb_rstto_icon_bar_prefetch:
+ * @user_data : A #RsttoIconBar.
+ *
+ * Requests the thumbnails of the "thumbnail-prefetch" items ahead of the
+ * visible items in the direction of scrolling, and of the same number of
+ * items around the active item. When too many thumbnails are being loaded
+ * already, it continues where it left off a little later.
+ **/
+static gboolean
+cb_rstto_icon_bar_prefetch (gpointer user_data)
+{
+    RsttoIconBar     *icon_bar = RSTTO_ICON_BAR (user_data);
+    RsttoFile        *file;
+    GtkTreeIter       iter;
+    gint              first, last;
+    gint              active;
+    gint              prefetch;
+    gint              n_items;
+    gint              step;
+    gint              index;
+
+    icon_bar->priv->prefetch_id = 0;
+
+    if (!GTK_WIDGET_REALIZED (icon_bar) ||
+        !RSTTO_ICON_BAR_VALID_MODEL_AND_COLUMNS (icon_bar) ||
+        !rstto_icon_bar_get_visible_range (icon_bar, &first, &last))
+        return FALSE;
+
+    prefetch = rstto_settings_get_uint_property (
+            icon_bar->priv->settings,
+            "thumbnail-prefetch");
+    active = icon_bar->priv->active;
+    n_items = icon_bar->priv->n_items;
+
+    for (; icon_bar->priv->prefetch_step < 2 * prefetch; ++icon_bar->priv->prefetch_step)
+    {
+        if (rstto_thumbnail_loader_get_n_pending (icon_bar->priv->thumbnail_loader) >=
+                RSTTO_ICON_BAR_PREFETCH_MAX_PENDING)
+        {
+            icon_bar->priv->prefetch_id = g_timeout_add_full (
+                    G_PRIORITY_DEFAULT_IDLE,
+                    RSTTO_ICON_BAR_PREFETCH_DELAY,
+                    cb_rstto_icon_bar_prefetch,
+                    icon_bar,
+                    NULL);
+            return FALSE;
+        }
+
+        step = icon_bar->priv->prefetch_step;
+        if (step < prefetch)
+        {
+            /* Ahead of the visible items */
+            if (icon_bar->priv->scroll_direction < 0)
+                index = first - 1 - step;
+            else
+                index = last + 1 + step;
+        }
+        else
+        {
+            /* Around the active item, nearest first */
+            if (active < 0)
+                break;
+
+            step -= prefetch;
+            if (step % 2 == 0)
+                index = active + step / 2 + 1;
+            else
+                index = active - step / 2 - 1;
+        }
+
+        /* The visible items are requested when they are drawn */
+        if (index < 0 || index >= n_items || (index >= first && index <= last))
+            continue;
+
+        if (!rstto_icon_bar_get_iter (icon_bar, index, &iter))
+            continue;
+
+        gtk_tree_model_get (icon_bar->priv->model, &iter,
+                icon_bar->priv->file_column, &file,
+                -1);
+
+        if (NULL == rstto_file_get_thumbnail (file, icon_bar->priv->thumbnail_size))
+            rstto_thumbnailer_set_position (icon_bar->priv->thumbnailer, file, index);
+
+        g_object_unref (file);
+    }
+
+    return FALSE;
+}
+
+
+
+/**
+ * cb_rstto_icon_bar_thumbnail_ready:
+ *
+ * Only the item of @file is redrawn, its size does not change. Thumbnails
+ * of items that are not visible are drawn once they are exposed.
+ **/
+static void
+cb_rstto_icon_bar_thumbnail_ready (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *file,
+        guint size,
+        gpointer user_data)
+{
+    RsttoIconBar     *icon_bar = RSTTO_ICON_BAR (user_data);
+    RsttoFile        *item_file;
+    GtkTreeIter       iter;
+    gint              first, last;
+    gint              n;
+
+    if (!GTK_WIDGET_REALIZED (icon_bar) ||
+        !RSTTO_ICON_BAR_VALID_MODEL_AND_COLUMNS (icon_bar) ||
+        size != icon_bar->priv->thumbnail_size)
+        return;
+
+    if (!rstto_icon_bar_get_visible_range (icon_bar, &first, &last))
+        return;
+
+    for (n = first; n <= last; ++n)
+    {
+        if (!rstto_icon_bar_get_iter (icon_bar, n, &iter))
+            break;
+
+        gtk_tree_model_get (icon_bar->priv->model, &iter,
+                icon_bar->priv->file_column, &item_file,
+                -1);
+        g_object_unref (item_file);
+
+        if (item_file == file)
+        {
+            rstto_icon_bar_queue_draw_item (icon_bar, n);
+            break;
+        }
+    }
+}
+
+
 static void
 rstto_icon_bar_update_missing_icon (RsttoIconBar *icon_bar)
 {
@@ -35,6 +35,7 @@
 #include "image_list.h"
 #include "thumbnailer.h"
 #include "settings.h"
+#include "dir_index.h"
 
 static void
 rstto_image_list_tree_model_init (GtkTreeModelIface *iface);
@@ -84,6 +85,66 @@ static void
 rstto_image_list_remove_all (
         RsttoImageList *image_list);
 
+static void
+rstto_image_list_watch_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file);
+
+static void
+rstto_image_list_unwatch_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file);
+
+static void
+rstto_parent_monitor_free (
+        gpointer data);
+
+static void
+rstto_image_list_add_index (
+        RsttoImageList *image_list,
+        GFile *dir,
+        RsttoDirIndex *index);
+
+static void
+rstto_image_list_save_index (
+        RsttoImageList *image_list,
+        gboolean force);
+
+static void
+rstto_image_list_add_other_file (
+        RsttoImageList *image_list,
+        const RsttoDirIndexEntry *entry);
+
+static gboolean
+rstto_image_list_filter_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file);
+
+static void
+rstto_image_list_merge_files (
+        RsttoImageList *image_list,
+        GList *files);
+
+static RsttoFile *
+rstto_image_list_nth_file (
+        RsttoImageList *image_list,
+        gint n);
+
+static void
+rstto_image_list_remove_files (
+        RsttoImageList *image_list,
+        GHashTable *files);
+
+static void
+rstto_image_list_queue_event (
+        RsttoImageList *image_list,
+        GFile *file,
+        gint event);
+
+static gboolean
+cb_rstto_image_list_flush_events (
+        gpointer user_data);
+
 static gboolean
 iter_next (
         RsttoImageListIter *iter,
@@ -195,6 +256,20 @@ enum
     RSTTO_IMAGE_LIST_ITER_SIGNAL_COUNT
 };
 
+/* Pending file-monitor events, a file has at most one */
+enum
+{
+    RSTTO_MONITOR_EVENT_NONE = 0,
+    RSTTO_MONITOR_EVENT_CHANGED,
+    RSTTO_MONITOR_EVENT_CREATED,
+    RSTTO_MONITOR_EVENT_DELETED
+};
+
+/* Time (ms) during which file-monitor events are collected
+ * before they are applied to the list.
+ */
+#define RSTTO_MONITOR_EVENT_DELAY 250
+
 struct _RsttoImageListIterPriv
 {
     RsttoImageList *image_list;
@@ -213,14 +288,53 @@ struct _RsttoImageListPriv
     RsttoThumbnailer *thumbnailer;
     GtkFileFilter *filter;
 
-    GList        *image_monitors;
+    /* Used when there is no directory-monitor, eg. when files are
+     * opened from the command-line. The files are watched through a
+     * shared monitor on their parent-directory.
+     */
+    GHashTable   *watched_files;
+    GHashTable   *parent_monitors;
+
     GList        *images;
     gint          n_images;
 
+    /* The link that was looked up last and its position, neighbouring
+     * rows are found from there. NULL when the list changed.
+     */
+    GList        *lookup_link;
+    gint          lookup_pos;
+
+    /* Set of the RsttoFiles in images */
+    GHashTable   *image_set;
+
+    /* GFile -> pending monitor-event */
+    GHashTable   *pending_events;
+    guint         pending_events_timeout;
+
     GSList       *iterators;
     GCompareFunc  cb_rstto_image_list_compare_func;
 
     gboolean      wrap_images;
+
+    /* Directory-index bookkeeping */
+    GFile        *dir;
+    /* name -> RsttoDirIndexEntry of the regular files in dir that
+     * are not in the list, they are stored in the index as well.
+     */
+    GHashTable   *other_files;
+    guint64       dir_mtime;
+    gboolean      index_dirty;
+    guint         n_index_orientations;
+};
+
+typedef struct _RsttoParentMonitor RsttoParentMonitor;
+
+struct _RsttoParentMonitor
+{
+    GFileMonitor *monitor;
+
+    /* Number of watched files in the directory */
+    guint         n_files;
 };
 
 typedef struct _RsttoFileLoader RsttoFileLoader;
@@ -233,10 +347,21 @@ struct _RsttoFileLoader
 
     guint            n_files;
     RsttoFile      **files;
+
+    /* The index the list was populated from, files that
+     * are not seen while enumerating are removed afterwards.
+     */
+    RsttoDirIndex   *index;
+    guint8          *seen;
+    gboolean         changed;
 };
 
 static gboolean
 cb_rstto_read_file ( gpointer user_data );
+static void
+rstto_file_loader_free ( gpointer user_data );
+static void
+rstto_file_loader_flush ( RsttoFileLoader *loader );
 
 static gint rstto_image_list_signals[RSTTO_IMAGE_LIST_SIGNAL_COUNT];
 static gint rstto_image_list_iter_signals[RSTTO_IMAGE_LIST_ITER_SIGNAL_COUNT];
@@ -326,6 +451,29 @@ rstto_image_list_init(RsttoImageList *image_list)
     g_object_ref_sink (image_list->priv->filter);
     gtk_file_filter_add_pixbuf_formats (image_list->priv->filter);
 
+    image_list->priv->image_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+    image_list->priv->watched_files = g_hash_table_new_full (
+            g_file_hash,
+            (GEqualFunc)g_file_equal,
+            g_object_unref,
+            NULL);
+    image_list->priv->parent_monitors = g_hash_table_new_full (
+            g_file_hash,
+            (GEqualFunc)g_file_equal,
+            g_object_unref,
+            rstto_parent_monitor_free);
+    image_list->priv->pending_events = g_hash_table_new_full (
+            g_file_hash,
+            (GEqualFunc)g_file_equal,
+            g_object_unref,
+            NULL);
+    /* The key is owned by the entry */
+    image_list->priv->other_files = g_hash_table_new_full (
+            g_str_hash,
+            g_str_equal,
+            NULL,
+            (GDestroyNotify)rstto_dir_index_entry_free);
+
     image_list->priv->cb_rstto_image_list_compare_func = (GCompareFunc)cb_rstto_image_list_image_name_compare_func;
 
     image_list->priv->wrap_images = rstto_settings_get_boolean_property (
@@ -403,6 +551,56 @@ rstto_image_list_dispose(GObject *object)
             g_object_unref (image_list->priv->filter);
             image_list->priv->filter= NULL;
         }
+
+        if (image_list->priv->dir)
+        {
+            rstto_image_list_save_index (image_list, FALSE);
+
+            g_object_unref (image_list->priv->dir);
+            image_list->priv->dir = NULL;
+        }
+
+        if (image_list->priv->directory_loader != 0)
+        {
+            g_source_remove (image_list->priv->directory_loader);
+            image_list->priv->directory_loader = 0;
+        }
+
+        if (image_list->priv->pending_events_timeout != 0)
+        {
+            g_source_remove (image_list->priv->pending_events_timeout);
+            image_list->priv->pending_events_timeout = 0;
+        }
+
+        if (image_list->priv->pending_events)
+        {
+            g_hash_table_destroy (image_list->priv->pending_events);
+            image_list->priv->pending_events = NULL;
+        }
+
+        if (image_list->priv->image_set)
+        {
+            g_hash_table_destroy (image_list->priv->image_set);
+            image_list->priv->image_set = NULL;
+        }
+
+        if (image_list->priv->other_files)
+        {
+            g_hash_table_destroy (image_list->priv->other_files);
+            image_list->priv->other_files = NULL;
+        }
+
+        if (image_list->priv->watched_files)
+        {
+            g_hash_table_destroy (image_list->priv->watched_files);
+            image_list->priv->watched_files = NULL;
+        }
+
+        if (image_list->priv->parent_monitors)
+        {
+            g_hash_table_destroy (image_list->priv->parent_monitors);
+            image_list->priv->parent_monitors = NULL;
+        }
         
         g_free (image_list->priv);
         image_list->priv = NULL;
@@ -419,32 +617,59 @@ rstto_image_list_new (void)
     return image_list;
 }
 
+/**
+ * rstto_image_list_filter_file:
+ * @image_list:
+ * @r_file:
+ *
+ * Return value: TRUE if @r_file is an image that can be shown.
+ */
+static gboolean
+rstto_image_list_filter_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file)
+{
+    GtkFileFilterInfo filter_info;
+
+    /* Only provide what the filter needs, the uri is not cached for
+     * every file in the list unless it has to be.
+     */
+    filter_info.contains = gtk_file_filter_get_needed (image_list->priv->filter) &
+            (GTK_FILE_FILTER_MIME_TYPE | GTK_FILE_FILTER_URI);
+    filter_info.uri = NULL;
+    filter_info.mime_type = NULL;
+
+    if (filter_info.contains & GTK_FILE_FILTER_URI)
+    {
+        filter_info.uri = rstto_file_get_uri (r_file);
+    }
+    if (filter_info.contains & GTK_FILE_FILTER_MIME_TYPE)
+    {
+        filter_info.mime_type = rstto_file_get_content_type (r_file);
+    }
+
+    return gtk_file_filter_filter (image_list->priv->filter, &filter_info);
+}
+
 gboolean
 rstto_image_list_add_file (
         RsttoImageList *image_list,
         RsttoFile *r_file,
         GError **error )
 {
-    GtkFileFilterInfo filter_info;
-    GList *image_iter = g_list_find (image_list->priv->images, r_file);
     GSList *iter = image_list->priv->iterators;
     gint i = 0;
     GtkTreePath *path = NULL;
     GtkTreeIter t_iter;
-    GFileMonitor *monitor = NULL;
 
     g_return_val_if_fail ( NULL != r_file , FALSE);
     g_return_val_if_fail ( RSTTO_IS_FILE (r_file) , FALSE);
 
-    if (!image_iter)
+    if (!g_hash_table_lookup (image_list->priv->image_set, r_file))
     {
         if (r_file)
         {
-            filter_info.contains =  GTK_FILE_FILTER_MIME_TYPE | GTK_FILE_FILTER_URI;
-            filter_info.uri = rstto_file_get_uri (r_file);
-            filter_info.mime_type = rstto_file_get_content_type (r_file);
-
-            if ( TRUE == gtk_file_filter_filter (image_list->priv->filter, &filter_info))
+            if ( TRUE == rstto_image_list_filter_file (image_list, r_file))
             {
                 g_object_ref (G_OBJECT (r_file));
 
@@ -452,25 +677,14 @@ rstto_image_list_add_file (
                         image_list->priv->images,
                         r_file,
                         rstto_image_list_get_compare_func (image_list));
+                g_hash_table_insert (image_list->priv->image_set, r_file, r_file);
+                image_list->priv->lookup_link = NULL;
 
                 image_list->priv->n_images++;
+                image_list->priv->index_dirty = TRUE;
+
+                rstto_image_list_watch_file (image_list, r_file);
 
-                if (image_list->priv->dir_monitor == NULL)
-                {
-                    monitor = g_file_monitor_file (
-                            rstto_file_get_file (r_file),
-                            G_FILE_MONITOR_NONE,
-                            NULL,
-                            NULL);
-                    g_signal_connect (
-                            G_OBJECT(monitor),
-                            "changed",
-                            G_CALLBACK (cb_file_monitor_changed),
-                            image_list);
-                    image_list->priv->image_monitors = g_list_prepend (
-                            image_list->priv->image_monitors, 
-                            monitor);
-                }
                 i = g_list_index (image_list->priv->images, r_file);
 
                 path = gtk_tree_path_new();
@@ -507,10 +721,153 @@ rstto_image_list_add_file (
     return TRUE;
 }
 
+/**
+ * rstto_image_list_merge_files:
+ * @image_list:
+ * @files: List of RsttoFiles that are not in @image_list yet,
+ *         the list and the references are taken over.
+ *
+ * Insert a batch of files in a single pass over the list, instead
+ * of a sorted insert per file.
+ */
+static void
+rstto_image_list_merge_files (
+        RsttoImageList *image_list,
+        GList *files)
+{
+    GCompareFunc compare_func = rstto_image_list_get_compare_func (image_list);
+    GList *position = image_list->priv->images;
+    GList *last = NULL;
+    GList *file_iter;
+    GSList *iter;
+    RsttoFile *r_file;
+    GtkTreePath *path;
+    GtkTreeIter t_iter;
+    gint index_ = 0;
+
+    files = g_list_sort (files, compare_func);
+
+    for (file_iter = files; file_iter != NULL; file_iter = g_list_next (file_iter))
+    {
+        r_file = file_iter->data;
+
+        while ( (NULL != position) &&
+                (compare_func (position->data, r_file) <= 0) )
+        {
+            last = position;
+            position = g_list_next (position);
+            index_++;
+        }
+
+        /* Keep track of the last link, appending is O(1) from there */
+        if (NULL != position)
+        {
+            image_list->priv->images = g_list_insert_before (
+                    image_list->priv->images,
+                    position,
+                    r_file);
+            last = position->prev;
+        }
+        else if (NULL != last)
+        {
+            last = g_list_next (g_list_append (last, r_file));
+        }
+        else
+        {
+            image_list->priv->images = g_list_append (NULL, r_file);
+            last = image_list->priv->images;
+        }
+
+        g_hash_table_insert (image_list->priv->image_set, r_file, r_file);
+        image_list->priv->n_images++;
+        image_list->priv->lookup_link = NULL;
+
+        rstto_image_list_watch_file (image_list, r_file);
+
+        path = gtk_tree_path_new();
+        gtk_tree_path_append_index (path, index_);
+        t_iter.stamp = image_list->priv->stamp;
+        t_iter.user_data = r_file;
+        t_iter.user_data3 = GINT_TO_POINTER(index_);
+
+        gtk_tree_model_row_inserted (
+                GTK_TREE_MODEL(image_list),
+                path,
+                &t_iter);
+
+        gtk_tree_path_free (path);
+        index_++;
+    }
+
+    if (NULL != files)
+    {
+        image_list->priv->index_dirty = TRUE;
+
+        iter = image_list->priv->iterators;
+        while (iter)
+        {
+            if (FALSE == RSTTO_IMAGE_LIST_ITER(iter->data)->priv->sticky)
+            {
+                rstto_image_list_iter_find_file (iter->data, files->data);
+            }
+            iter = g_slist_next (iter);
+        }
+    }
+
+    g_list_free (files);
+}
+
 gint
 rstto_image_list_get_n_images (RsttoImageList *image_list)
 {
-    return g_list_length (image_list->priv->images);
+    return image_list->priv->n_images;
+}
+
+/**
+ * rstto_image_list_nth_file:
+ * @image_list:
+ * @n:
+ *
+ * Look up the file at position @n, starting from the position that
+ * was looked up last. A view walking the visible rows, or stepping
+ * to the next row, does not walk the list from the start every time.
+ *
+ * Return value: the file, NULL if @n is out of range.
+ */
+static RsttoFile *
+rstto_image_list_nth_file (
+        RsttoImageList *image_list,
+        gint n)
+{
+    GList *link = image_list->priv->lookup_link;
+    gint pos = image_list->priv->lookup_pos;
+
+    if ( (n < 0) || (n >= image_list->priv->n_images) )
+    {
+        return NULL;
+    }
+
+    if ( (NULL == link) || (ABS (n - pos) > n) )
+    {
+        link = image_list->priv->images;
+        pos = 0;
+    }
+
+    while (pos < n)
+    {
+        link = g_list_next (link);
+        pos++;
+    }
+    while (pos > n)
+    {
+        link = g_list_previous (link);
+        pos--;
+    }
+
+    image_list->priv->lookup_link = link;
+    image_list->priv->lookup_pos = pos;
+
+    return link->data;
 }
 
 /**
@@ -578,6 +935,7 @@ rstto_image_list_remove_file (
                 {
 
                     image_list->priv->images = g_list_remove (image_list->priv->images, r_file);
+                    image_list->priv->lookup_link = NULL;
                     ((RsttoImageListIter *)(iter->data))->priv->r_file = NULL;
                     g_signal_emit (
                             G_OBJECT (iter->data),
@@ -590,6 +948,12 @@ rstto_image_list_remove_file (
         }
 
         image_list->priv->images = g_list_remove (image_list->priv->images, r_file);
+        g_hash_table_remove (image_list->priv->image_set, r_file);
+        image_list->priv->n_images--;
+        image_list->priv->lookup_link = NULL;
+        image_list->priv->index_dirty = TRUE;
+
+        rstto_image_list_unwatch_file (image_list, r_file);
 
         path_ = gtk_tree_path_new();
         gtk_tree_path_append_index(path_,index_);
@@ -620,6 +984,111 @@ rstto_image_list_remove_file (
     }
 }
 
+/**
+ * rstto_image_list_remove_files:
+ * @image_list:
+ * @files: Set of RsttoFiles to remove
+ *
+ * Remove a batch of files in a single pass over the list. Iterators
+ * pointing to a removed file move to the next remaining file.
+ */
+static void
+rstto_image_list_remove_files (
+        RsttoImageList *image_list,
+        GHashTable *files)
+{
+    GSList *iter = NULL;
+    GList *image_iter = NULL;
+    GList *next = NULL;
+    GList *position = NULL;
+    RsttoImageListIter *r_iter;
+    RsttoFile *r_file = NULL;
+    GtkTreePath *path_ = NULL;
+    gint index_ = 0;
+
+    for (iter = image_list->priv->iterators; iter != NULL; iter = g_slist_next (iter))
+    {
+        r_iter = iter->data;
+        if ( (NULL == r_iter->priv->r_file) ||
+             (NULL == g_hash_table_lookup (files, r_iter->priv->r_file)) )
+        {
+            continue;
+        }
+
+        position = g_list_find (image_list->priv->images, r_iter->priv->r_file);
+        r_file = NULL;
+
+        for (image_iter = g_list_next (position); image_iter != NULL; image_iter = g_list_next (image_iter))
+        {
+            if (NULL == g_hash_table_lookup (files, image_iter->data))
+            {
+                r_file = image_iter->data;
+                break;
+            }
+        }
+        if (NULL == r_file)
+        {
+            for (image_iter = g_list_previous (position); image_iter != NULL; image_iter = g_list_previous (image_iter))
+            {
+                if (NULL == g_hash_table_lookup (files, image_iter->data))
+                {
+                    r_file = image_iter->data;
+                    break;
+                }
+            }
+        }
+
+        g_signal_emit (
+                G_OBJECT (r_iter),
+                rstto_image_list_iter_signals[RSTTO_IMAGE_LIST_ITER_SIGNAL_PREPARE_CHANGE],
+                0,
+                NULL);
+        r_iter->priv->r_file = r_file;
+    }
+
+    image_iter = image_list->priv->images;
+    while (image_iter)
+    {
+        next = g_list_next (image_iter);
+        r_file = image_iter->data;
+
+        if (NULL != g_hash_table_lookup (files, r_file))
+        {
+            image_list->priv->images = g_list_delete_link (
+                    image_list->priv->images,
+                    image_iter);
+            g_hash_table_remove (image_list->priv->image_set, r_file);
+            image_list->priv->n_images--;
+            image_list->priv->lookup_link = NULL;
+
+            rstto_image_list_unwatch_file (image_list, r_file);
+
+            path_ = gtk_tree_path_new();
+            gtk_tree_path_append_index(path_, index_);
+
+            gtk_tree_model_row_deleted(GTK_TREE_MODEL(image_list), path_);
+
+            gtk_tree_path_free (path_);
+
+            g_signal_emit (
+                    G_OBJECT (image_list),
+                    rstto_image_list_signals[RSTTO_IMAGE_LIST_SIGNAL_REMOVE_IMAGE],
+                    0,
+                    r_file,
+                    NULL);
+            g_object_unref (r_file);
+        }
+        else
+        {
+            index_++;
+        }
+
+        image_iter = next;
+    }
+
+    image_list->priv->index_dirty = TRUE;
+}
+
 static void
 rstto_image_list_remove_all (RsttoImageList *image_list)
 {
@@ -640,75 +1109,452 @@ rstto_image_list_remove_all (RsttoImageList *image_list)
         image_iter = g_list_next (image_iter);     
     }
 
-    g_list_foreach (image_list->priv->image_monitors, (GFunc)g_object_unref, NULL);
-    g_list_free (image_list->priv->image_monitors);
-    image_list->priv->image_monitors = NULL;
+    g_hash_table_remove_all (image_list->priv->watched_files);
+    g_hash_table_remove_all (image_list->priv->parent_monitors);
 
     g_list_foreach (image_list->priv->images, (GFunc)g_object_unref, NULL);
     g_list_free (image_list->priv->images);
     image_list->priv->images = NULL;
+    image_list->priv->n_images = 0;
+    image_list->priv->lookup_link = NULL;
+    g_hash_table_remove_all (image_list->priv->image_set);
+    g_hash_table_remove_all (image_list->priv->other_files);
+
+    /* Events for the old files are of no interest anymore */
+    g_hash_table_remove_all (image_list->priv->pending_events);
+    if (image_list->priv->pending_events_timeout != 0)
+    {
+        g_source_remove (image_list->priv->pending_events_timeout);
+        image_list->priv->pending_events_timeout = 0;
+    }
 
     iter = image_list->priv->iterators;
     while (iter)
     {
-        iter_set_position (iter->data, -1, FALSE);
-        iter = g_slist_next (iter);
+        iter_set_position (iter->data, -1, FALSE);
+        iter = g_slist_next (iter);
+    }
+    g_signal_emit (G_OBJECT (image_list), rstto_image_list_signals[RSTTO_IMAGE_LIST_SIGNAL_REMOVE_ALL], 0, NULL);
+}
+
+gboolean
+rstto_image_list_set_directory (
+        RsttoImageList *image_list,
+        GFile *dir,
+        GError **error )
+{
+    /* Declare variables */
+    GFileEnumerator *file_enumerator = NULL;
+    RsttoFileLoader *loader = NULL;
+    RsttoDirIndex *index = NULL;
+
+    /* Source code block */
+    if (image_list->priv->dir)
+    {
+        /* Store what we learned about the previous directory,
+         * eg. orientations that were read while browsing.
+         */
+        rstto_image_list_save_index (image_list, FALSE);
+
+        g_object_unref (image_list->priv->dir);
+        image_list->priv->dir = NULL;
+    }
+
+    if (image_list->priv->directory_loader != 0)
+    {
+        g_source_remove (image_list->priv->directory_loader);
+        image_list->priv->directory_loader = 0;
+    }
+
+    rstto_image_list_remove_all (image_list);
+
+    rstto_image_list_monitor_dir ( 
+            image_list,
+            dir );
+
+    /* Allow all images to be removed by providing NULL to dir */
+    if ( NULL != dir )
+    {
+        image_list->priv->dir = g_object_ref (dir);
+        image_list->priv->dir_mtime = rstto_dir_index_query_mtime (dir);
+
+        /* Show the indexed files right away, the directory is
+         * reconciled with the index in the background.
+         */
+        index = rstto_dir_index_load (dir, image_list->priv->dir_mtime);
+        if (NULL != index)
+        {
+            rstto_image_list_add_index (image_list, dir, index);
+
+            /* The content-type of unchanged files is known from the
+             * index, do not sniff every file in the directory again.
+             */
+            file_enumerator = g_file_enumerate_children (
+                    dir,
+                    "standard::name,standard::type,standard::size,time::modified",
+                    0,
+                    NULL,
+                    NULL);
+        }
+        else
+        {
+            file_enumerator = g_file_enumerate_children (dir, "standard::*", 0, NULL, NULL);
+        }
+
+        image_list->priv->index_dirty = FALSE;
+
+        if (NULL != file_enumerator)
+        {
+            g_object_ref (dir);
+
+            loader = g_new0 (RsttoFileLoader, 1);
+            loader->dir = dir;
+            loader->file_enum = file_enumerator;
+            loader->image_list = image_list;
+            loader->index = index;
+            if (NULL != index)
+            {
+                loader->seen = g_new0 (guint8, rstto_dir_index_get_n_entries (index));
+            }
+
+            image_list->priv->directory_loader = g_idle_add_full (
+                    G_PRIORITY_DEFAULT_IDLE,
+                    (GSourceFunc) cb_rstto_read_file,
+                    loader,
+                    rstto_file_loader_free);
+        }
+        else
+        {
+            rstto_dir_index_free (index);
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * rstto_image_list_add_index:
+ * @image_list:
+ * @dir:
+ * @index:
+ *
+ * Populate the (empty) image-list from the directory-index, the
+ * files are sorted once instead of being inserted one-by-one.
+ */
+static void
+rstto_image_list_add_index (
+        RsttoImageList *image_list,
+        GFile *dir,
+        RsttoDirIndex *index)
+{
+    RsttoDirIndexEntry entry;
+    RsttoFile *r_file;
+    GFile *child_file;
+    GList *images = NULL;
+    GList *image_iter;
+    GSList *iter;
+    GtkTreePath *path;
+    GtkTreeIter t_iter;
+    guint n_entries = rstto_dir_index_get_n_entries (index);
+    guint n_orientations = 0;
+    guint i;
+    gint n = 0;
+
+    for (i = 0; i < n_entries; ++i)
+    {
+        rstto_dir_index_get_entry (index, i, &entry);
+
+        /* Do not create RsttoFiles for the files that are not shown */
+        if (strncmp (entry.content_type, "image/", 6) != 0)
+        {
+            rstto_image_list_add_other_file (image_list, &entry);
+            continue;
+        }
+
+        child_file = g_file_get_child (dir, entry.name);
+        r_file = rstto_file_new (child_file);
+        g_object_unref (child_file);
+
+        rstto_file_set_content_type (r_file, entry.content_type);
+        rstto_file_set_file_info (r_file, entry.modified_time, entry.size);
+        if (entry.orientation != 0)
+        {
+            rstto_file_set_orientation (r_file, entry.orientation);
+            n_orientations++;
+        }
+        rstto_file_set_metadata (
+                r_file,
+                entry.capture_time,
+                entry.width,
+                entry.height);
+
+        if ( TRUE == rstto_image_list_filter_file (image_list, r_file))
+        {
+            images = g_list_prepend (images, r_file);
+            g_hash_table_insert (image_list->priv->image_set, r_file, r_file);
+        }
+        else
+        {
+            rstto_image_list_add_other_file (image_list, &entry);
+            g_object_unref (r_file);
+        }
+    }
+
+    image_list->priv->images = g_list_sort (
+            images,
+            rstto_image_list_get_compare_func (image_list));
+    image_list->priv->n_images = g_list_length (image_list->priv->images);
+    image_list->priv->lookup_link = NULL;
+    image_list->priv->n_index_orientations = n_orientations;
+
+    for (image_iter = image_list->priv->images; image_iter != NULL; image_iter = g_list_next (image_iter))
+    {
+        path = gtk_tree_path_new();
+        gtk_tree_path_append_index (path, n);
+        t_iter.stamp = image_list->priv->stamp;
+        t_iter.user_data = image_iter->data;
+        t_iter.user_data3 = GINT_TO_POINTER(n);
+
+        gtk_tree_model_row_inserted (
+                GTK_TREE_MODEL(image_list),
+                path,
+                &t_iter);
+
+        gtk_tree_path_free (path);
+        n++;
+    }
+
+    if (NULL != image_list->priv->images)
+    {
+        iter = image_list->priv->iterators;
+        while (iter)
+        {
+            if (FALSE == RSTTO_IMAGE_LIST_ITER(iter->data)->priv->sticky)
+            {
+                rstto_image_list_iter_find_file (
+                        iter->data,
+                        image_list->priv->images->data);
+            }
+            iter = g_slist_next (iter);
+        }
+    }
+}
+
+/**
+ * rstto_image_list_save_index:
+ * @image_list:
+ * @force: Write the index even if nothing changed since it was read.
+ *
+ * Write the directory-index if the list of files changed, or if
+ * more orientations are known than are stored in the index.
+ */
+static void
+rstto_image_list_save_index (
+        RsttoImageList *image_list,
+        gboolean force)
+{
+    GList *other_entries;
+    GList *image_iter;
+    guint n_orientations = 0;
+
+    if (NULL == image_list->priv->dir)
+    {
+        return;
+    }
+
+    /* A partially enumerated directory would result in an
+     * incomplete index.
+     */
+    if (image_list->priv->directory_loader != 0)
+    {
+        return;
+    }
+
+    for (image_iter = image_list->priv->images; image_iter != NULL; image_iter = g_list_next (image_iter))
+    {
+        if (rstto_file_has_orientation (image_iter->data))
+        {
+            n_orientations++;
+        }
+    }
+
+    if ( (TRUE == force) ||
+         (TRUE == image_list->priv->index_dirty) ||
+         (n_orientations > image_list->priv->n_index_orientations) )
+    {
+        other_entries = g_hash_table_get_values (image_list->priv->other_files);
+
+        if (rstto_dir_index_save (
+                image_list->priv->dir,
+                image_list->priv->dir_mtime,
+                image_list->priv->images,
+                other_entries))
+        {
+            image_list->priv->index_dirty = FALSE;
+            image_list->priv->n_index_orientations = n_orientations;
+        }
+
+        g_list_free (other_entries);
+    }
+}
+
+/**
+ * rstto_image_list_add_other_file:
+ * @image_list:
+ * @entry: A regular file in the directory that is not in the list,
+ *         the entry is copied.
+ */
+static void
+rstto_image_list_add_other_file (
+        RsttoImageList *image_list,
+        const RsttoDirIndexEntry *entry)
+{
+    RsttoDirIndexEntry *copy = rstto_dir_index_entry_copy (entry);
+
+    /* Replace the key too, it is owned by the old entry */
+    g_hash_table_replace (
+            image_list->priv->other_files,
+            (gpointer)copy->name,
+            copy);
+}
+
+static void
+rstto_file_loader_free ( gpointer user_data )
+{
+    RsttoFileLoader *loader = user_data;
+    guint i;
+
+    for (i = 0; i < loader->n_files; ++i)
+    {
+        g_object_unref (loader->files[i]);
+    }
+    g_free (loader->files);
+
+    if (NULL != loader->index)
+    {
+        rstto_dir_index_free (loader->index);
+    }
+    g_free (loader->seen);
+
+    g_object_unref (loader->file_enum);
+    g_object_unref (loader->dir);
+    g_free (loader);
+}
+
+/**
+ * rstto_file_loader_flush:
+ * @loader:
+ *
+ * Add the files collected by @loader to the list in a single merge,
+ * instead of a sorted insert per file.
+ */
+static void
+rstto_file_loader_flush ( RsttoFileLoader *loader )
+{
+    RsttoImageList *image_list = loader->image_list;
+    GList *files = NULL;
+    guint i;
+
+    for (i = 0; i < loader->n_files; ++i)
+    {
+        /* A file-monitor event may have added it already */
+        if (NULL == g_hash_table_lookup (image_list->priv->image_set, loader->files[i]))
+        {
+            /* The reference is taken over by the list */
+            files = g_list_prepend (files, loader->files[i]);
+        }
+        else
+        {
+            g_object_unref (loader->files[i]);
+        }
+    }
+    g_free (loader->files);
+    loader->files = NULL;
+    loader->n_files = 0;
+
+    if (NULL != files)
+    {
+        rstto_image_list_merge_files (image_list, files);
     }
-    g_signal_emit (G_OBJECT (image_list), rstto_image_list_signals[RSTTO_IMAGE_LIST_SIGNAL_REMOVE_ALL], 0, NULL);
 }
 
-gboolean
-rstto_image_list_set_directory (
-        RsttoImageList *image_list,
-        GFile *dir,
-        GError **error )
+/**
+ * rstto_image_list_reconcile_file:
+ * @loader:
+ * @file_info:
+ *
+ * Compare an enumerated file with the directory-index.
+ *
+ * Return value: TRUE if the file is already in the list and has not
+ *               been modified since the index was written.
+ */
+static gboolean
+rstto_image_list_reconcile_file (
+        RsttoFileLoader *loader,
+        GFileInfo *file_info)
 {
-    /* Declare variables */
-    GFileEnumerator *file_enumerator = NULL;
-    RsttoFileLoader *loader = NULL;
+    RsttoDirIndexEntry entry;
+    RsttoFile *r_file;
+    GFile *child_file;
+    guint64 modified_time;
+    guint64 size;
+    gint pos;
 
-    /* Source code block */
-    if (image_list->priv->directory_loader != 0)
+    pos = rstto_dir_index_lookup (loader->index, g_file_info_get_name (file_info));
+    if (pos < 0)
     {
-        g_source_remove (image_list->priv->directory_loader);
-        image_list->priv->directory_loader = 0;
+        return FALSE;
     }
 
-    rstto_image_list_remove_all (image_list);
+    loader->seen[pos] = TRUE;
 
-    rstto_image_list_monitor_dir ( 
-            image_list,
-            dir );
+    rstto_dir_index_get_entry (loader->index, pos, &entry);
+    modified_time = g_file_info_get_attribute_uint64 (file_info, "time::modified");
+    size = g_file_info_get_size (file_info);
 
-    /* Allow all images to be removed by providing NULL to dir */
-    if ( NULL != dir )
+    if ( (entry.modified_time == modified_time) &&
+         (entry.size == size) )
     {
-        file_enumerator = g_file_enumerate_children (dir, "standard::*", 0, NULL, NULL);
-
-        if (NULL != file_enumerator)
-        {
-            g_object_ref (dir);
+        return TRUE;
+    }
 
-            loader = g_new0 (RsttoFileLoader, 1);
-            loader->dir = dir;
-            loader->file_enum = file_enumerator;
-            loader->image_list = image_list;
+    loader->changed = TRUE;
 
-            image_list->priv->directory_loader = g_idle_add ( (GSourceFunc) cb_rstto_read_file, loader );
-        }
+    /* A modified file that was not shown is sniffed again below */
+    if (g_hash_table_remove (loader->image_list->priv->other_files, entry.name))
+    {
+        return FALSE;
     }
 
-    return TRUE;
+    /* The file was modified, drop the cached information. If it is
+     * still an image it is re-added and re-sorted below.
+     */
+    child_file = g_file_get_child (loader->dir, entry.name);
+    r_file = rstto_file_new (child_file);
+    g_object_unref (child_file);
+
+    rstto_image_list_remove_file (loader->image_list, r_file);
+
+    rstto_file_set_content_type (r_file, NULL);
+    rstto_file_set_orientation (r_file, 0);
+    rstto_file_changed (r_file);
+
+    g_object_unref (r_file);
+
+    return FALSE;
 }
 
 static gboolean
 cb_rstto_read_file ( gpointer user_data )
 {
     RsttoFileLoader *loader = user_data;
+    RsttoImageList  *image_list = loader->image_list;
+    RsttoDirIndexEntry entry;
     GFileInfo       *file_info;
     const gchar     *content_type;
     const gchar     *filename;
     RsttoFile      **files;
+    RsttoFile       *r_file;
     GFile           *child_file;
     guint            i;
     GSList          *iter;
@@ -726,36 +1572,63 @@ cb_rstto_read_file ( gpointer user_data )
         /* Allow for 'progressive' loading */
         if (loader->n_files == 100)
         {
-            for (i = 0; i < loader->n_files; ++i)
-            {
-                rstto_image_list_add_file (
-                        loader->image_list,
-                        loader->files[i],
-                        NULL);
-
-                g_object_unref (loader->files[i]);
-            }
+            rstto_file_loader_flush (loader);
 
-            iter = loader->image_list->priv->iterators;
+            iter = image_list->priv->iterators;
             while (iter)
             {
                 g_signal_emit (G_OBJECT (iter->data), rstto_image_list_iter_signals[RSTTO_IMAGE_LIST_ITER_SIGNAL_CHANGED], 0, NULL);
                 iter = g_slist_next (iter);
             }
+        }
+
+        if ( (NULL != loader->index) &&
+             (TRUE == rstto_image_list_reconcile_file (loader, file_info)) )
+        {
+            /* Unchanged, already in the list */
+            g_object_unref (file_info);
+            return TRUE;
+        }
 
-            g_free (loader->files);
-            loader->files = NULL;
-            loader->n_files = 0;
+        if (g_file_info_get_file_type (file_info) != G_FILE_TYPE_REGULAR)
+        {
+            g_object_unref (file_info);
+            return TRUE;
+        }
+
+        filename = g_file_info_get_name (file_info);
+        child_file = g_file_get_child (loader->dir, filename);
+        r_file = rstto_file_new (child_file);
+        g_object_unref (child_file);
+
+        if (NULL != loader->index)
+        {
+            /* The content-type was not requested, it is sniffed
+             * below. Only files that are new or modified get here,
+             * unchanged files were found in the index.
+             */
+            loader->changed = TRUE;
+        }
+        else
+        {
+            rstto_file_set_content_type (
+                    r_file,
+                    g_file_info_get_content_type (file_info));
         }
 
+        rstto_file_set_file_info (
+                r_file,
+                g_file_info_get_attribute_uint64 (file_info, "time::modified"),
+                g_file_info_get_size (file_info));
+
         /* Add file to the list */
-        content_type  = g_file_info_get_content_type (file_info);
-        if (strncmp (content_type, "image/", 6) == 0)
+        content_type = rstto_file_get_content_type (r_file);
+        if ( (NULL != content_type) &&
+             (strncmp (content_type, "image/", 6) == 0) &&
+             (TRUE == rstto_image_list_filter_file (image_list, r_file)) )
         {
-            filename = g_file_info_get_name (file_info);
-            child_file = g_file_get_child (loader->dir, filename);
             files = g_new0 ( RsttoFile *, loader->n_files+1);
-            files[0] = rstto_file_new (child_file);
+            files[0] = r_file;
 
             for (i = 0; i < loader->n_files; ++i)
             {
@@ -769,40 +1642,67 @@ cb_rstto_read_file ( gpointer user_data )
             loader->files = files;
             loader->n_files++;
         }
+        else
+        {
+            memset (&entry, 0, sizeof (RsttoDirIndexEntry));
+            entry.name = filename;
+            entry.content_type = content_type;
+            entry.modified_time = rstto_file_get_modified_time (r_file);
+            entry.size = rstto_file_get_size (r_file);
+
+            rstto_image_list_add_other_file (image_list, &entry);
+
+            g_object_unref (r_file);
+        }
+
+        g_object_unref (file_info);
     }
     else
     {
-        for (i = 0; i < loader->n_files; ++i)
+        rstto_file_loader_flush (loader);
+
+        /* Remove the indexed files that no longer exist */
+        if (NULL != loader->index)
         {
-            rstto_image_list_add_file (
-                    loader->image_list,
-                    loader->files[i],
-                    NULL);
+            for (i = 0; i < rstto_dir_index_get_n_entries (loader->index); ++i)
+            {
+                if (FALSE == loader->seen[i])
+                {
+                    rstto_dir_index_get_entry (loader->index, i, &entry);
 
-            g_object_unref (loader->files[i]);
-        }
+                    loader->changed = TRUE;
 
-        /* This is a hack, use a closure */
-        if (loader->image_list->priv->directory_loader != 0)
-        {
-            g_source_remove (loader->image_list->priv->directory_loader);
-            loader->image_list->priv->directory_loader = 0;
+                    if (g_hash_table_remove (image_list->priv->other_files, entry.name))
+                    {
+                        continue;
+                    }
+
+                    child_file = g_file_get_child (loader->dir, entry.name);
+                    r_file = rstto_file_new (child_file);
+                    g_object_unref (child_file);
+
+                    rstto_image_list_remove_file (image_list, r_file);
+                    g_object_unref (r_file);
+                }
+            }
         }
 
-        iter = loader->image_list->priv->iterators;
+        image_list->priv->directory_loader = 0;
+
+        iter = image_list->priv->iterators;
         while (iter)
         {
             g_signal_emit (G_OBJECT (iter->data), rstto_image_list_iter_signals[RSTTO_IMAGE_LIST_ITER_SIGNAL_CHANGED], 0, NULL);
             iter = g_slist_next (iter);
         }
 
-        if (loader->n_files > 0)
-        {
-            g_free (loader->files);
-        }
-        g_object_unref (loader->file_enum);
-        g_free (loader);
+        rstto_image_list_save_index (
+                image_list,
+                ( (NULL == loader->index) ||
+                  (TRUE == loader->changed) ||
+                  (FALSE == rstto_dir_index_is_current (loader->index)) ));
 
+        /* The loader is freed by rstto_file_loader_free */
         return FALSE;
     }
     return TRUE;
@@ -837,14 +1737,114 @@ rstto_image_list_monitor_dir (
                 image_list);
     }
 
-    if (image_list->priv->image_monitors)
+    g_hash_table_remove_all (image_list->priv->watched_files);
+    g_hash_table_remove_all (image_list->priv->parent_monitors);
+
+    image_list->priv->dir_monitor = monitor;
+}
+
+static void
+rstto_parent_monitor_free (
+        gpointer data)
+{
+    RsttoParentMonitor *parent_monitor = data;
+
+    if (NULL != parent_monitor->monitor)
+    {
+        g_file_monitor_cancel (parent_monitor->monitor);
+        g_object_unref (parent_monitor->monitor);
+    }
+    g_free (parent_monitor);
+}
+
+/**
+ * rstto_image_list_watch_file:
+ * @image_list:
+ * @r_file:
+ *
+ * Watch @r_file for changes if the list has no directory-monitor.
+ * All files in the same directory share a single monitor, instead
+ * of using a watch per file.
+ */
+static void
+rstto_image_list_watch_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file)
+{
+    RsttoParentMonitor *parent_monitor;
+    GFile *file = rstto_file_get_file (r_file);
+    GFile *parent;
+
+    if ( (NULL != image_list->priv->dir_monitor) ||
+         (NULL != g_hash_table_lookup (image_list->priv->watched_files, file)) )
+    {
+        return;
+    }
+
+    parent = g_file_get_parent (file);
+    if (NULL == parent)
     {
-        g_list_foreach (image_list->priv->image_monitors, (GFunc)g_object_unref, NULL);
-        g_list_free (image_list->priv->image_monitors);
-        image_list->priv->image_monitors = NULL;
+        return;
     }
 
-    image_list->priv->dir_monitor = monitor;
+    g_hash_table_insert (image_list->priv->watched_files, g_object_ref (file), file);
+
+    parent_monitor = g_hash_table_lookup (image_list->priv->parent_monitors, parent);
+    if (NULL == parent_monitor)
+    {
+        parent_monitor = g_new0 (RsttoParentMonitor, 1);
+        parent_monitor->monitor = g_file_monitor_directory (
+                parent,
+                G_FILE_MONITOR_SEND_MOVED,
+                NULL,
+                NULL);
+        if (NULL != parent_monitor->monitor)
+        {
+            g_signal_connect (
+                    G_OBJECT(parent_monitor->monitor),
+                    "changed",
+                    G_CALLBACK (cb_file_monitor_changed),
+                    image_list);
+        }
+
+        /* The hash-table takes over the reference to parent */
+        g_hash_table_insert (image_list->priv->parent_monitors, parent, parent_monitor);
+    }
+    else
+    {
+        g_object_unref (parent);
+    }
+
+    parent_monitor->n_files++;
+}
+
+static void
+rstto_image_list_unwatch_file (
+        RsttoImageList *image_list,
+        RsttoFile *r_file)
+{
+    RsttoParentMonitor *parent_monitor;
+    GFile *file = rstto_file_get_file (r_file);
+    GFile *parent;
+
+    if (FALSE == g_hash_table_remove (image_list->priv->watched_files, file))
+    {
+        return;
+    }
+
+    parent = g_file_get_parent (file);
+
+    parent_monitor = g_hash_table_lookup (image_list->priv->parent_monitors, parent);
+    if (NULL != parent_monitor)
+    {
+        parent_monitor->n_files--;
+        if (0 == parent_monitor->n_files)
+        {
+            g_hash_table_remove (image_list->priv->parent_monitors, parent);
+        }
+    }
+
+    g_object_unref (parent);
 }
 
 static void
@@ -856,67 +1856,174 @@ cb_file_monitor_changed (
         gpointer           user_data )
 {
     RsttoImageList *image_list = RSTTO_IMAGE_LIST (user_data);
-    RsttoFile *r_file = rstto_file_new (file);
+
+    /* A shared parent-directory monitor reports events for every
+     * file in the directory, only the files in the list are of
+     * interest.
+     */
+    if ( (monitor != image_list->priv->dir_monitor) &&
+         (NULL == g_hash_table_lookup (image_list->priv->watched_files, file)) )
+    {
+        /* An atomic save renames a temporary file onto a file in
+         * the list, the listed file has changed.
+         */
+        if ( (G_FILE_MONITOR_EVENT_MOVED == event_type) &&
+             (NULL != other_file) &&
+             (NULL != g_hash_table_lookup (image_list->priv->watched_files, other_file)) )
+        {
+            rstto_image_list_queue_event (image_list, other_file, RSTTO_MONITOR_EVENT_CHANGED);
+        }
+        return;
+    }
 
     switch ( event_type )
     {
         case G_FILE_MONITOR_EVENT_DELETED:
-            rstto_image_list_remove_file ( image_list, r_file );
-            if (image_list->priv->dir_monitor == NULL)
-            {
-                image_list->priv->image_monitors = g_list_remove (
-                        image_list->priv->image_monitors,
-                        monitor);   
-                g_object_unref (monitor);
-                monitor = NULL;
-            }
+            rstto_image_list_queue_event (image_list, file, RSTTO_MONITOR_EVENT_DELETED);
             break;
         case G_FILE_MONITOR_EVENT_CREATED:
-            rstto_image_list_add_file (image_list, r_file, NULL);
+            rstto_image_list_queue_event (image_list, file, RSTTO_MONITOR_EVENT_CREATED);
             break;
         case G_FILE_MONITOR_EVENT_MOVED:
-            rstto_image_list_remove_file ( image_list, r_file );
-
-            /* Remove our reference, reusing pointer */
-            g_object_unref (r_file);
-
-            r_file = rstto_file_new (other_file);
-            rstto_image_list_add_file (image_list, r_file, NULL);
-
-            if (image_list->priv->dir_monitor == NULL)
-            {
-                image_list->priv->image_monitors = g_list_remove (
-                        image_list->priv->image_monitors,
-                        monitor);   
-                g_object_unref (monitor);
-                monitor = g_file_monitor_file (
-                        other_file,
-                        G_FILE_MONITOR_NONE,
-                        NULL,
-                        NULL);
-                g_signal_connect (
-                        G_OBJECT(monitor),
-                        "changed",
-                        G_CALLBACK (cb_file_monitor_changed),
-                        image_list);
-                image_list->priv->image_monitors = g_list_prepend (
-                        image_list->priv->image_monitors, 
-                        monitor);
-            }
+            rstto_image_list_queue_event (image_list, file, RSTTO_MONITOR_EVENT_DELETED);
+            /* The renamed file is added, and watched, when the
+             * events are applied.
+             */
+            rstto_image_list_queue_event (image_list, other_file, RSTTO_MONITOR_EVENT_CREATED);
             break;
         case G_FILE_MONITOR_EVENT_CHANGED:
-            rstto_file_changed (r_file);
+            rstto_image_list_queue_event (image_list, file, RSTTO_MONITOR_EVENT_CHANGED);
             break;
         default:
             break;
     }
+}
+
+/**
+ * rstto_image_list_queue_event:
+ * @image_list:
+ * @file:
+ * @event:
+ *
+ * Collect file-monitor events, a burst of events (eg. a camera
+ * import) is applied to the list at once when it has settled.
+ * Only the last created/deleted event for a file is relevant, a
+ * changed event is implied by either of those.
+ */
+static void
+rstto_image_list_queue_event (
+        RsttoImageList *image_list,
+        GFile *file,
+        gint event)
+{
+    gint pending = GPOINTER_TO_INT (g_hash_table_lookup (
+            image_list->priv->pending_events,
+            file));
+
+    if ( (event != RSTTO_MONITOR_EVENT_CHANGED) ||
+         (pending == RSTTO_MONITOR_EVENT_NONE) )
+    {
+        g_hash_table_insert (
+                image_list->priv->pending_events,
+                g_object_ref (file),
+                GINT_TO_POINTER (event));
+    }
 
-    if ( NULL != r_file )
+    /* Do not re-arm the timeout, a continuous stream of events
+     * is applied in batches.
+     */
+    if (image_list->priv->pending_events_timeout == 0)
     {
-        g_object_unref (r_file);
+        image_list->priv->pending_events_timeout = g_timeout_add (
+                RSTTO_MONITOR_EVENT_DELAY,
+                cb_rstto_image_list_flush_events,
+                image_list);
     }
 }
 
+static gboolean
+cb_rstto_image_list_flush_events (
+        gpointer user_data)
+{
+    RsttoImageList *image_list = RSTTO_IMAGE_LIST (user_data);
+    GHashTableIter hash_iter;
+    GHashTable *removed_files;
+    GList *added_files = NULL;
+    RsttoFile *r_file;
+    gpointer key;
+    gpointer value;
+    GSList *iter;
+
+    image_list->priv->pending_events_timeout = 0;
+
+    removed_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    g_hash_table_iter_init (&hash_iter, image_list->priv->pending_events);
+    while (g_hash_table_iter_next (&hash_iter, &key, &value))
+    {
+        r_file = rstto_file_new (G_FILE (key));
+
+        switch (GPOINTER_TO_INT (value))
+        {
+            case RSTTO_MONITOR_EVENT_CREATED:
+                if (NULL != g_hash_table_lookup (image_list->priv->image_set, r_file))
+                {
+                    /* Replaced */
+                    rstto_file_changed (r_file);
+                }
+                else if (TRUE == rstto_image_list_filter_file (image_list, r_file))
+                {
+                    /* The reference is taken over by the list */
+                    added_files = g_list_prepend (added_files, r_file);
+                    r_file = NULL;
+                }
+                break;
+            case RSTTO_MONITOR_EVENT_DELETED:
+                if (NULL != g_hash_table_lookup (image_list->priv->image_set, r_file))
+                {
+                    g_hash_table_insert (removed_files, r_file, r_file);
+                }
+                break;
+            case RSTTO_MONITOR_EVENT_CHANGED:
+                if (NULL != g_hash_table_lookup (image_list->priv->image_set, r_file))
+                {
+                    rstto_file_changed (r_file);
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (NULL != r_file)
+        {
+            g_object_unref (r_file);
+        }
+    }
+    g_hash_table_remove_all (image_list->priv->pending_events);
+
+    /* GtkTreeModel has no batch-signals, the row-signals are
+     * emitted during a single pass over the list.
+     */
+    if (g_hash_table_size (removed_files) > 0)
+    {
+        rstto_image_list_remove_files (image_list, removed_files);
+    }
+    g_hash_table_destroy (removed_files);
+
+    if (NULL != added_files)
+    {
+        rstto_image_list_merge_files (image_list, added_files);
+    }
+
+    iter = image_list->priv->iterators;
+    while (iter)
+    {
+        g_signal_emit (G_OBJECT (iter->data), rstto_image_list_iter_signals[RSTTO_IMAGE_LIST_ITER_SIGNAL_CHANGED], 0, NULL);
+        iter = g_slist_next (iter);
+    }
+
+    return FALSE;
+}
 
 
 GType
@@ -1081,7 +2188,7 @@ iter_set_position (
 
     if (pos >= 0)
     {
-        iter->priv->r_file = g_list_nth_data (iter->priv->image_list->priv->images, pos); 
+        iter->priv->r_file = rstto_image_list_nth_file (iter->priv->image_list, pos);
     }
 
     g_signal_emit (
@@ -1315,8 +2422,42 @@ void
 rstto_image_list_set_compare_func (RsttoImageList *image_list, GCompareFunc func)
 {
     GSList *iter = NULL;
+    GHashTable *old_positions;
+    GList *image_iter;
+    GtkTreePath *path;
+    gint *new_order;
+    gint i = 0;
+
+    /* Remember where the files were, for the rows-reordered signal */
+    old_positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (image_iter = image_list->priv->images; image_iter != NULL; image_iter = g_list_next (image_iter))
+    {
+        g_hash_table_insert (old_positions, image_iter->data, GINT_TO_POINTER (i++));
+    }
+
     image_list->priv->cb_rstto_image_list_compare_func = func;
     image_list->priv->images = g_list_sort (image_list->priv->images,  func);
+    image_list->priv->lookup_link = NULL;
+
+    if (NULL != image_list->priv->images)
+    {
+        new_order = g_new (gint, image_list->priv->n_images);
+        i = 0;
+        for (image_iter = image_list->priv->images; image_iter != NULL; image_iter = g_list_next (image_iter))
+        {
+            new_order[i++] = GPOINTER_TO_INT (g_hash_table_lookup (old_positions, image_iter->data));
+        }
+
+        path = gtk_tree_path_new ();
+        gtk_tree_model_rows_reordered (
+                GTK_TREE_MODEL (image_list),
+                path,
+                NULL,
+                new_order);
+        gtk_tree_path_free (path);
+        g_free (new_order);
+    }
+    g_hash_table_destroy (old_positions);
 
     for (iter = image_list->priv->iterators; iter != NULL; iter = g_slist_next (iter))
     {
@@ -1474,11 +2615,7 @@ image_list_model_get_iter (
 
     index_ = indices[depth];
 
-    if (index_ >= 0)
-    {
-        file = g_list_nth_data (image_list->priv->images, index_);
-    }
-
+    file = rstto_image_list_nth_file (image_list, index_);
     if (NULL == file)
     {
         return FALSE;
@@ -1528,7 +2665,7 @@ image_list_model_iter_children (
 
     image_list = RSTTO_IMAGE_LIST (tree_model);
     
-    file = g_list_nth_data (image_list->priv->images, 0);
+    file = rstto_image_list_nth_file (image_list, 0);
 
     if (NULL == file)
     {
@@ -1564,7 +2701,15 @@ image_list_model_iter_n_children (
         GtkTreeModel *tree_model,
         GtkTreeIter *iter )
 {
-    return FALSE;
+    g_return_val_if_fail(RSTTO_IS_IMAGE_LIST(tree_model), 0);
+
+    /* only support lists: the rows have no children */
+    if (NULL != iter)
+    {
+        return 0;
+    }
+
+    return RSTTO_IMAGE_LIST (tree_model)->priv->n_images;
 }
 
 static gboolean 
@@ -1574,7 +2719,30 @@ image_list_model_iter_nth_child (
         GtkTreeIter *parent,
         gint n )
 {
-    return FALSE;
+    RsttoImageList *image_list;
+    RsttoFile *file = NULL;
+
+    g_return_val_if_fail(RSTTO_IS_IMAGE_LIST(tree_model), FALSE);
+
+    /* only support lists: parent is always NULL */
+    if ( (NULL != parent) || (n < 0) )
+    {
+        return FALSE;
+    }
+
+    image_list = RSTTO_IMAGE_LIST (tree_model);
+
+    file = rstto_image_list_nth_file (image_list, n);
+    if (NULL == file)
+    {
+        return FALSE;
+    }
+
+    iter->stamp = image_list->priv->stamp;
+    iter->user_data = file;
+    iter->user_data3 = GINT_TO_POINTER(n);
+
+    return TRUE;
 }
 
 static gboolean
@@ -1590,11 +2758,10 @@ image_list_model_iter_next (
 
     image_list = RSTTO_IMAGE_LIST (tree_model);
 
-    file = iter->user_data;
     pos = GPOINTER_TO_INT(iter->user_data3);
     pos++;
 
-    file = g_list_nth_data (image_list->priv->images, pos);
+    file = rstto_image_list_nth_file (image_list, pos);
 
     if (NULL == file)
     {
@@ -86,6 +86,12 @@ struct _RsttoImageViewerPriv
     GError                      *error;
 
     RsttoImageViewerTransaction *transaction;
+
+    /* The image that is expected to be shown next, it is loaded
+     * in advance. See rstto_image_viewer_preload_file.
+     */
+    RsttoImageViewerTransaction *preload;
+
     GdkPixbuf                   *pixbuf;
     RsttoImageOrientation        orientation;
     struct
@@ -151,6 +157,12 @@ struct _RsttoImageViewerTransaction
     gdouble           scale;
     RsttoImageOrientation orientation;
 
+    /* The loader emitted area-prepared / closed, used when a
+     * preloaded transaction is shown.
+     */
+    gboolean          prepared;
+    gboolean          loaded;
+
     /* File I/O data */
     /*****************/
     guchar           *buffer;
@@ -276,8 +288,15 @@ rstto_image_viewer_load_image (
         RsttoImageViewer *viewer,
         RsttoFile *file,
         gdouble scale);
+static RsttoImageViewerTransaction *
+rstto_image_viewer_transaction_new (
+        RsttoImageViewer *viewer,
+        RsttoFile *file,
+        gdouble scale);
 static void
 rstto_image_viewer_transaction_free (RsttoImageViewerTransaction *tr);
+static void
+rstto_image_viewer_cancel_preload (RsttoImageViewer *viewer);
 
 static GtkWidgetClass *parent_class = NULL;
 static GdkScreen      *default_screen = NULL;
@@ -455,6 +474,13 @@ rstto_image_viewer_class_init(RsttoImageViewerClass *viewer_class)
             NULL, NULL,
             g_cclosure_marshal_VOID__VOID,
             G_TYPE_NONE, 0);
+    g_signal_new ("preload-ready",
+            G_TYPE_FROM_CLASS (object_class),
+            G_SIGNAL_RUN_FIRST,
+            0,
+            NULL, NULL,
+            g_cclosure_marshal_VOID__VOID,
+            G_TYPE_NONE, 0);
     g_signal_new ("files-dnd",
             G_TYPE_FROM_CLASS (object_class),
             G_SIGNAL_RUN_FIRST,
@@ -657,6 +683,8 @@ rstto_image_viewer_destroy(GtkObject *object)
 
     if (viewer->priv)
     {
+        rstto_image_viewer_cancel_preload (viewer);
+
         if (viewer->priv->settings)
         {
             g_object_unref (viewer->priv->settings);
@@ -1733,7 +1761,8 @@ rstto_image_viewer_load_image (
         RsttoFile *file,
         gdouble scale)
 {
-    RsttoImageViewerTransaction *transaction = g_new0 (RsttoImageViewerTransaction, 1);
+    RsttoImageViewerTransaction *transaction = viewer->priv->preload;
+    GtkWidget *widget = GTK_WIDGET (viewer);
 
     /*
      * This will first need to return to the 'main' loop before it cleans up after itself.
@@ -1745,6 +1774,48 @@ rstto_image_viewer_load_image (
         viewer->priv->transaction = NULL;
     }
 
+    if ( (NULL == transaction) ||
+         (FALSE == rstto_file_equal (transaction->file, file)) )
+    {
+        viewer->priv->transaction = rstto_image_viewer_transaction_new (
+                viewer,
+                file,
+                scale);
+        return;
+    }
+
+    /* The file was preloaded, continue with that transaction. Replay
+     * the loader-signals it already emitted, now that it is current.
+     */
+    viewer->priv->preload = NULL;
+    viewer->priv->transaction = transaction;
+    transaction->scale = scale;
+
+    if (TRUE == transaction->prepared)
+    {
+        cb_rstto_image_loader_area_prepared (transaction->loader, transaction);
+    }
+
+    if (TRUE == transaction->loaded)
+    {
+        cb_rstto_image_loader_closed (transaction->loader, transaction);
+
+        /* Show the image right away, instead of at the next expose */
+        if (GTK_WIDGET_REALIZED (widget))
+        {
+            gdk_window_process_updates (widget->window, FALSE);
+        }
+    }
+}
+
+static RsttoImageViewerTransaction *
+rstto_image_viewer_transaction_new (
+        RsttoImageViewer *viewer,
+        RsttoFile *file,
+        gdouble scale)
+{
+    RsttoImageViewerTransaction *transaction = g_new0 (RsttoImageViewerTransaction, 1);
+
     transaction->loader = gdk_pixbuf_loader_new_with_mime_type (rstto_file_get_content_type (file), NULL);
 
     /* HACK HACK HACK */
@@ -1755,7 +1826,7 @@ rstto_image_viewer_load_image (
 
     transaction->cancellable = g_cancellable_new();
     transaction->buffer = g_new0 (guchar, RSTTO_IMAGE_VIEWER_BUFFER_SIZE);
-    transaction->file = file;
+    transaction->file = g_object_ref (file);
     transaction->viewer = viewer;
     transaction->scale = scale;
 
@@ -1763,13 +1834,13 @@ rstto_image_viewer_load_image (
     g_signal_connect(transaction->loader, "size-prepared", G_CALLBACK(cb_rstto_image_loader_size_prepared), transaction);
     g_signal_connect(transaction->loader, "closed", G_CALLBACK(cb_rstto_image_loader_closed), transaction);
 
-    viewer->priv->transaction = transaction;
-
     g_file_read_async (rstto_file_get_file (transaction->file),
                        0,
                        transaction->cancellable,
                        (GAsyncReadyCallback)cb_rstto_image_viewer_read_file_ready,
                        transaction);
+
+    return transaction;
 }
 
 static void
@@ -1783,16 +1854,109 @@ rstto_image_viewer_transaction_free (RsttoImageViewerTransaction *tr)
     {
         tr->viewer->priv->transaction = NULL;
     }
+    if (tr->viewer->priv->preload == tr)
+    {
+        tr->viewer->priv->preload = NULL;
+    }
     if (tr->error)
     {
         g_error_free (tr->error);
     }
     g_object_unref (tr->cancellable);
     g_object_unref (tr->loader);
+    g_object_unref (tr->file);
     g_free (tr->buffer);
     g_free (tr);
 }
 
+/**
+ * rstto_image_viewer_cancel_preload:
+ * @viewer:
+ *
+ * Drop the preloaded image, or stop loading it.
+ */
+static void
+rstto_image_viewer_cancel_preload (RsttoImageViewer *viewer)
+{
+    RsttoImageViewerTransaction *preload = viewer->priv->preload;
+
+    if (NULL == preload)
+    {
+        return;
+    }
+
+    viewer->priv->preload = NULL;
+
+    if (TRUE == preload->loaded)
+    {
+        rstto_image_viewer_transaction_free (preload);
+    }
+    else
+    {
+        /* The closed-callback frees the transaction */
+        g_cancellable_cancel (preload->cancellable);
+    }
+}
+
+/**
+ * rstto_image_viewer_preload_file:
+ * @viewer:
+ * @file: The file that is shown next, or NULL
+ *
+ * Load @file in advance, at the size it is shown at. When it is set
+ * with rstto_image_viewer_set_file it is shown without delay.
+ * "preload-ready" is emitted when it is loaded. Only one file is
+ * preloaded at a time.
+ */
+void
+rstto_image_viewer_preload_file (
+        RsttoImageViewer *viewer,
+        RsttoFile *file)
+{
+    if ( (NULL != file) &&
+         (NULL != viewer->priv->preload) &&
+         (TRUE == rstto_file_equal (viewer->priv->preload->file, file)) )
+    {
+        return;
+    }
+
+    rstto_image_viewer_cancel_preload (viewer);
+
+    if ( (NULL != file) &&
+         ( (NULL == viewer->priv->file) ||
+           (FALSE == rstto_file_equal (viewer->priv->file, file)) ) )
+    {
+        viewer->priv->preload = rstto_image_viewer_transaction_new (
+                viewer,
+                file,
+                viewer->priv->scale);
+    }
+}
+
+/**
+ * rstto_image_viewer_is_preloaded:
+ * @viewer:
+ * @file:
+ *
+ * Return value: TRUE if @file can be shown without loading it first.
+ */
+gboolean
+rstto_image_viewer_is_preloaded (
+        RsttoImageViewer *viewer,
+        RsttoFile *file)
+{
+    if ( (NULL != viewer->priv->file) &&
+         (NULL == viewer->priv->transaction) &&
+         (TRUE == rstto_file_equal (viewer->priv->file, file)) )
+    {
+        return TRUE;
+    }
+
+    return ( (NULL != viewer->priv->preload) &&
+             (TRUE == viewer->priv->preload->loaded) &&
+             (TRUE == rstto_file_equal (viewer->priv->preload->file, file)) );
+}
+
 void
 rstto_image_viewer_set_scale (
         RsttoImageViewer *viewer,
@@ -1988,10 +2152,12 @@ cb_rstto_image_viewer_read_file_ready (
     GFile *file = G_FILE (source_object);
     RsttoImageViewerTransaction *transaction = (RsttoImageViewerTransaction *)user_data;
 
-    GFileInputStream *file_input_stream = g_file_read_finish (file, result, NULL);
+    GFileInputStream *file_input_stream = g_file_read_finish (file, result, &transaction->error);
 
     if (file_input_stream == NULL)
     {
+        /* Finish the transaction, the closed-callback cleans it up */
+        gdk_pixbuf_loader_close (transaction->loader, NULL);
         return;
     }
 
@@ -2057,6 +2223,8 @@ cb_rstto_image_loader_area_prepared (
     gint timeout = 0;
     RsttoImageViewer *viewer = transaction->viewer;
 
+    transaction->prepared = TRUE;
+
     if (viewer->priv->transaction == transaction)
     {
         if (viewer->priv->iter)
@@ -2172,6 +2340,15 @@ cb_rstto_image_loader_closed (
     RsttoImageViewer *viewer = transaction->viewer;
     GtkWidget *widget = GTK_WIDGET(viewer);
 
+    transaction->loaded = TRUE;
+
+    /* Keep the result until the file is shown */
+    if (viewer->priv->preload == transaction)
+    {
+        g_signal_emit_by_name(viewer, "preload-ready");
+        return;
+    }
+
     if (viewer->priv->transaction == transaction)
     {
         
@@ -2207,9 +2384,13 @@ cb_rstto_image_loader_closed (
                 widget->window,
                 NULL,
                 FALSE);
+
+        g_signal_emit_by_name(transaction->viewer, "size-ready");
     }
 
-    g_signal_emit_by_name(transaction->viewer, "size-ready");
+    /* A cancelled transaction, eg. a preload that was not shown, is
+     * of no interest to the statusbar.
+     */
     rstto_image_viewer_transaction_free (transaction);
 }
 
@@ -3013,6 +3194,13 @@ cb_rstto_image_viewer_file_changed (
         RsttoFile        *r_file,
         RsttoImageViewer *viewer )
 {
+    /* A preloaded copy of the file is outdated */
+    if ( (NULL != viewer->priv->preload) &&
+         (TRUE == rstto_file_equal (viewer->priv->preload->file, r_file)) )
+    {
+        rstto_image_viewer_cancel_preload (viewer);
+    }
+
     rstto_image_viewer_load_image (
             viewer,
             r_file,
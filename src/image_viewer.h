@@ -121,6 +121,16 @@ gboolean
 rstto_image_viewer_is_busy (
         RsttoImageViewer *viewer );
 
+void
+rstto_image_viewer_preload_file (
+        RsttoImageViewer *viewer,
+        RsttoFile *file);
+
+gboolean
+rstto_image_viewer_is_preloaded (
+        RsttoImageViewer *viewer,
+        RsttoFile *file);
+
 
 G_END_DECLS
 
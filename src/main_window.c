@@ -39,6 +39,7 @@
 #include "file.h"
 #include "icon_bar.h"
 #include "thumbnailer.h"
+#include "thumbnail_loader.h"
 #include "image_list.h"
 #include "image_viewer.h"
 #include "main_window.h"
@@ -62,6 +63,17 @@
 #define RSTTO_RECENT_FILES_APP_NAME "ristretto"
 #define RSTTO_RECENT_FILES_GROUP "Graphics"
 
+/* Start loading the next slide at least this many seconds before it is
+ * due, or twice the average load-time if that is longer.
+ */
+#define RSTTO_SLIDESHOW_MIN_LOOKAHEAD 1.0
+
+/* While a late slide is loading, check on it this often (ms). The
+ * preload can become the current image, eg. when the user navigates,
+ * and then "preload-ready" is never emitted.
+ */
+#define RSTTO_SLIDESHOW_WAIT_INTERVAL 100
+
 enum
 {
     EDITOR_CHOOSER_MODEL_COLUMN_NAME = 0,
@@ -96,6 +108,7 @@ struct _RsttoMainWindowPriv
     RsttoSettings         *settings_manager;
     RsttoWallpaperManager *wallpaper_manager;
     RsttoThumbnailer      *thumbnailer;
+    RsttoThumbnailLoader  *thumbnail_loader;
 
     GtkWidget             *menubar;
     GtkWidget             *toolbar;
@@ -111,6 +124,15 @@ struct _RsttoMainWindowPriv
     GtkWidget             *statusbar;
     guint                  statusbar_context_id;
 
+    /* The statusbar-message without the zoom-level, NULL if the
+     * zoom-level is not shown. A zoom-change only appends the new
+     * zoom-level to it.
+     */
+    gchar                 *statusbar_text;
+
+    /* The file the statusbar waits for the metadata of */
+    RsttoFile             *metadata_file;
+
     GtkWidget             *back;
     GtkWidget             *forward;
 
@@ -130,7 +152,28 @@ struct _RsttoMainWindowPriv
     gboolean               playing;
     gint                   play_timeout_id;
 
+    /* Slideshow schedule, in seconds since the slideshow started. A
+     * slide is due at play_deadline, the next slide is preloaded
+     * before that. play_preload_time is -1 if it has not started yet.
+     */
+    GTimer                *play_timer;
+    gdouble                play_interval;
+    gdouble                play_deadline;
+    gdouble                play_preload_time;
+    gdouble                play_load_time;
+    gboolean               play_waiting;
+
     GtkFileFilter         *filter;
+
+    /* The open-with menus are filled when they are shown, from
+     * the applications per content-type.
+     */
+    GtkWidget             *open_with_menu;
+    GtkWidget             *open_with_window_menu;
+    GHashTable            *app_lists;
+#if GLIB_CHECK_VERSION (2, 40, 0)
+    GAppInfoMonitor       *app_info_monitor;
+#endif
 };
 
 enum
@@ -168,6 +211,12 @@ cb_rstto_thumbnailer_ready(
         RsttoThumbnailer *thumbnailer,
         RsttoFile *file,
         gpointer user_data);
+static void
+cb_rstto_thumbnail_loader_ready (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *file,
+        guint size,
+        gpointer user_data);
 
 static gboolean
 rstto_window_save_geometry_timer (gpointer user_data);
@@ -175,6 +224,17 @@ rstto_window_save_geometry_timer (gpointer user_data);
 static void
 rstto_main_window_image_list_iter_changed (RsttoMainWindow *window);
 
+static void
+rstto_main_window_update_open_with_menu (
+        RsttoMainWindow *window,
+        GtkWidget *menu);
+static GList *
+rstto_main_window_get_app_list (
+        RsttoMainWindow *window,
+        const gchar *content_type);
+static void
+rstto_main_window_free_app_list (gpointer app_list);
+
 static void
 rstto_main_window_launch_editor_chooser (
         RsttoMainWindow *window);
@@ -188,7 +248,19 @@ cb_rstto_main_window_show_fs_toolbar_timeout (RsttoMainWindow *window);
 static void
 cb_rstto_main_window_image_list_iter_changed (RsttoImageListIter *iter, RsttoMainWindow *window);
 static void
+cb_rstto_main_window_open_with_menu_show (GtkWidget *menu, RsttoMainWindow *window);
+#if GLIB_CHECK_VERSION (2, 40, 0)
+static void
+cb_rstto_main_window_app_info_changed (GAppInfoMonitor *monitor, RsttoMainWindow *window);
+#endif
+static void
 rstto_main_window_update_statusbar (RsttoMainWindow *window);
+static void
+rstto_main_window_update_statusbar_scale (RsttoMainWindow *window);
+static void
+rstto_main_window_set_metadata_file (
+        RsttoMainWindow *window,
+        RsttoFile *r_file);
 
 static void
 cb_rstto_main_window_zoom_100 (GtkWidget *widget, RsttoMainWindow *window);
@@ -254,6 +326,10 @@ static gboolean
 cb_rstto_main_window_navigationtoolbar_button_press_event (GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 static void
 cb_rstto_main_window_update_statusbar (GtkWidget *widget, RsttoMainWindow *window);
+static void
+cb_rstto_main_window_scale_changed (GtkWidget *widget, RsttoMainWindow *window);
+static void
+cb_rstto_main_window_metadata_ready (RsttoFile *r_file, RsttoMainWindow *window);
 
 static void
 cb_rstto_main_window_play (
@@ -266,6 +342,22 @@ cb_rstto_main_window_pause(
 static gboolean
 cb_rstto_main_window_play_slideshow (
         RsttoMainWindow *window);
+static void
+cb_rstto_main_window_preload_ready (
+        GtkWidget *widget,
+        RsttoMainWindow *window);
+static void
+rstto_main_window_schedule_slideshow (
+        RsttoMainWindow *window);
+static void
+rstto_main_window_next_slide (
+        RsttoMainWindow *window);
+static void
+rstto_main_window_restart_slide (
+        RsttoMainWindow *window);
+static RsttoFile *
+rstto_main_window_get_next_slide (
+        RsttoMainWindow *window);
 
 static void
 cb_rstto_main_window_toggle_show_toolbar (
@@ -772,6 +864,7 @@ rstto_main_window_init (RsttoMainWindow *window)
     window->priv->recent_manager = gtk_recent_manager_get_default();
     window->priv->settings_manager = rstto_settings_new();
     window->priv->thumbnailer = rstto_thumbnailer_new();
+    window->priv->thumbnail_loader = rstto_thumbnail_loader_new();
 
     /* Setup the image filter list for drag and drop */
     window->priv->filter = gtk_file_filter_new ();
@@ -893,6 +986,35 @@ rstto_main_window_init (RsttoMainWindow *window)
     window->priv->toolbar = gtk_ui_manager_get_widget (window->priv->ui_manager, "/main-toolbar");
     window->priv->image_viewer_menu = gtk_ui_manager_get_widget (window->priv->ui_manager, "/image-viewer-menu");
     window->priv->position_menu = gtk_ui_manager_get_widget (window->priv->ui_manager, "/navigation-toolbar-menu");
+
+    window->priv->app_lists = g_hash_table_new_full (
+            g_str_hash,
+            g_str_equal,
+            g_free,
+            rstto_main_window_free_app_list);
+#if GLIB_CHECK_VERSION (2, 40, 0)
+    window->priv->app_info_monitor = g_app_info_monitor_get ();
+    g_signal_connect (
+            G_OBJECT (window->priv->app_info_monitor),
+            "changed",
+            G_CALLBACK (cb_rstto_main_window_app_info_changed),
+            window);
+#endif
+
+    window->priv->open_with_menu = gtk_menu_new ();
+    window->priv->open_with_window_menu = gtk_menu_new ();
+    gtk_menu_item_set_submenu (GTK_MENU_ITEM (gtk_ui_manager_get_widget ( window->priv->ui_manager, "/image-viewer-menu/open-with-menu")), window->priv->open_with_menu);
+    gtk_menu_item_set_submenu (GTK_MENU_ITEM (gtk_ui_manager_get_widget ( window->priv->ui_manager, "/main-menu/edit-menu/open-with-menu")), window->priv->open_with_window_menu);
+    g_signal_connect (
+            G_OBJECT (window->priv->open_with_menu),
+            "show",
+            G_CALLBACK (cb_rstto_main_window_open_with_menu_show),
+            window);
+    g_signal_connect (
+            G_OBJECT (window->priv->open_with_window_menu),
+            "show",
+            G_CALLBACK (cb_rstto_main_window_open_with_menu_show),
+            window);
     window->priv->warning = gtk_info_bar_new();
     window->priv->warning_label = gtk_label_new(NULL);
     gtk_label_set_ellipsize (
@@ -1102,8 +1224,9 @@ rstto_main_window_init (RsttoMainWindow *window)
     g_signal_connect(G_OBJECT(window), "window-state-event", G_CALLBACK(cb_rstto_main_window_state_event), NULL);
     g_signal_connect(G_OBJECT(window->priv->thumbnailbar), "button-press-event", G_CALLBACK(cb_rstto_main_window_navigationtoolbar_button_press_event), window);
     g_signal_connect(G_OBJECT(window->priv->image_viewer), "size-ready", G_CALLBACK(cb_rstto_main_window_update_statusbar), window);
-    g_signal_connect(G_OBJECT(window->priv->image_viewer), "scale-changed", G_CALLBACK(cb_rstto_main_window_update_statusbar), window);
+    g_signal_connect(G_OBJECT(window->priv->image_viewer), "scale-changed", G_CALLBACK(cb_rstto_main_window_scale_changed), window);
     g_signal_connect(G_OBJECT(window->priv->image_viewer), "status-changed", G_CALLBACK(cb_rstto_main_window_update_statusbar), window);
+    g_signal_connect(G_OBJECT(window->priv->image_viewer), "preload-ready", G_CALLBACK(cb_rstto_main_window_preload_ready), window);
     g_signal_connect(G_OBJECT(window->priv->image_viewer), "files-dnd", G_CALLBACK(cb_rstto_main_window_dnd_files), window);
 
     g_signal_connect (
@@ -1122,6 +1245,11 @@ rstto_main_window_init (RsttoMainWindow *window)
             "ready",
             G_CALLBACK (cb_rstto_thumbnailer_ready),
             window);
+    g_signal_connect (
+            G_OBJECT(window->priv->thumbnail_loader),
+            "ready",
+            G_CALLBACK (cb_rstto_thumbnail_loader_ready),
+            window);
 
 }
 
@@ -1181,6 +1309,50 @@ rstto_main_window_dispose(GObject *object)
             g_object_unref (window->priv->thumbnailer);
             window->priv->thumbnailer = NULL;
         }
+
+        if (window->priv->thumbnail_loader)
+        {
+            g_signal_handlers_disconnect_by_func (
+                    window->priv->thumbnail_loader,
+                    cb_rstto_thumbnail_loader_ready,
+                    window);
+            g_object_unref (window->priv->thumbnail_loader);
+            window->priv->thumbnail_loader = NULL;
+        }
+
+        if (window->priv->play_timeout_id)
+        {
+            g_source_remove (window->priv->play_timeout_id);
+            window->priv->play_timeout_id = 0;
+        }
+
+        if (window->priv->play_timer)
+        {
+            g_timer_destroy (window->priv->play_timer);
+            window->priv->play_timer = NULL;
+        }
+
+        rstto_main_window_set_metadata_file (window, NULL);
+        g_free (window->priv->statusbar_text);
+        window->priv->statusbar_text = NULL;
+
+#if GLIB_CHECK_VERSION (2, 40, 0)
+        if (window->priv->app_info_monitor)
+        {
+            g_signal_handlers_disconnect_by_func (
+                    window->priv->app_info_monitor,
+                    cb_rstto_main_window_app_info_changed,
+                    window);
+            g_object_unref (window->priv->app_info_monitor);
+            window->priv->app_info_monitor = NULL;
+        }
+#endif
+
+        if (window->priv->app_lists)
+        {
+            g_hash_table_destroy (window->priv->app_lists);
+            window->priv->app_lists = NULL;
+        }
         g_free (window->priv);
         window->priv = NULL;
     }
@@ -1261,19 +1433,8 @@ rstto_main_window_image_list_iter_changed (RsttoMainWindow *window)
     RsttoFile *cur_file = NULL;
     gint position, count;
     RsttoImageList *image_list = window->priv->image_list;
-    GList *app_list, *iter;
-    const gchar *content_type;
-    const gchar *editor;
-    const gchar *id;
-    GtkWidget *menu_item = NULL;
-    GDesktopAppInfo *app_info = NULL;
     const GdkPixbuf *pixbuf = NULL;
 
-    GtkWidget *open_with_menu = gtk_menu_new();
-    GtkWidget *open_with_window_menu = gtk_menu_new();
-    gtk_menu_item_set_submenu (GTK_MENU_ITEM (gtk_ui_manager_get_widget ( window->priv->ui_manager, "/image-viewer-menu/open-with-menu")), open_with_menu);
-    gtk_menu_item_set_submenu (GTK_MENU_ITEM (gtk_ui_manager_get_widget ( window->priv->ui_manager, "/main-menu/edit-menu/open-with-menu")), open_with_window_menu);
-
     if (window->priv->image_list)
     {
         position = rstto_image_list_iter_get_position (window->priv->iter);
@@ -1283,7 +1444,11 @@ rstto_main_window_image_list_iter_changed (RsttoMainWindow *window)
         {
             rstto_icon_bar_set_active (RSTTO_ICON_BAR (window->priv->thumbnailbar), position);
             rstto_icon_bar_show_active (RSTTO_ICON_BAR (window->priv->thumbnailbar));
-            content_type  = rstto_file_get_content_type (cur_file);
+
+            /* The orientation is needed as soon as the image is
+             * loaded, read it in the background right away.
+             */
+            rstto_file_load_metadata (cur_file);
 
             rstto_image_viewer_set_file (
                     RSTTO_IMAGE_VIEWER(window->priv->image_viewer),
@@ -1302,66 +1467,6 @@ rstto_main_window_image_list_iter_changed (RsttoMainWindow *window)
                 gtk_window_set_icon_name (GTK_WINDOW (window), "ristretto");
             }
 
-            app_list = g_app_info_get_all_for_type (content_type);
-            editor = rstto_mime_db_lookup (window->priv->db, content_type);
-
-            if (editor)
-            {
-                app_info = g_desktop_app_info_new (editor);
-                if ( app_info != NULL )
-                {
-                    menu_item = rstto_app_menu_item_new (G_APP_INFO (app_info), rstto_file_get_file (cur_file));
-                    gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-                    menu_item = rstto_app_menu_item_new (G_APP_INFO (app_info), rstto_file_get_file (cur_file));
-                    gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-
-                    menu_item = gtk_separator_menu_item_new ();
-                    gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-                    menu_item = gtk_separator_menu_item_new ();
-                    gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-                }
-            }
-
-            if (NULL != app_list)
-            {
-                for (iter = app_list; iter; iter = g_list_next (iter))
-                {
-                    id = g_app_info_get_id (iter->data);
-                    if (strcmp (id, RISTRETTO_DESKTOP_ID))
-                    {
-                        if ((!editor) || (editor && strcmp (id, editor)))
-                        {
-                            menu_item = rstto_app_menu_item_new (iter->data, rstto_file_get_file (cur_file));
-                            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-                            menu_item = rstto_app_menu_item_new (iter->data, rstto_file_get_file (cur_file));
-                            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-                        }
-                    }
-                }
-
-                menu_item = gtk_separator_menu_item_new ();
-                gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-                menu_item = gtk_separator_menu_item_new ();
-                gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-
-                g_list_foreach (app_list, (GFunc)g_object_unref, NULL);
-                g_list_free (app_list);
-            }
-            else
-            {
-            }
-
-            menu_item = gtk_menu_item_new_with_mnemonic (_("Open With Other _Application..."));
-            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-            g_signal_connect(G_OBJECT(menu_item), "activate", G_CALLBACK(cb_rstto_main_window_open_with_other_app), window);
-
-            menu_item = gtk_menu_item_new_with_mnemonic (_("Open With Other _Application..."));
-            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-            g_signal_connect(G_OBJECT(menu_item), "activate", G_CALLBACK(cb_rstto_main_window_open_with_other_app), window);
-
-            gtk_widget_show_all (open_with_menu);
-            gtk_widget_show_all (open_with_window_menu);
-
             file_basename = rstto_file_get_display_name (cur_file);
 
             if (count > 1)
@@ -1376,19 +1481,8 @@ rstto_main_window_image_list_iter_changed (RsttoMainWindow *window)
         }
         else
         {
-            menu_item = gtk_image_menu_item_new_with_label (_("Empty"));
-            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_menu), menu_item);
-            gtk_widget_set_sensitive (menu_item, FALSE);
-
             rstto_image_viewer_set_file (RSTTO_IMAGE_VIEWER(window->priv->image_viewer), NULL, -1, 0);
 
-            menu_item = gtk_image_menu_item_new_with_label (_("Empty"));
-            gtk_menu_shell_append (GTK_MENU_SHELL (open_with_window_menu), menu_item);
-            gtk_widget_set_sensitive (menu_item, FALSE);
-
-            gtk_widget_show_all (open_with_menu);
-            gtk_widget_show_all (open_with_window_menu);
-
             title = g_strdup (RISTRETTO_APP_TITLE);
 
             gtk_window_set_icon (GTK_WINDOW (window), NULL);
@@ -1403,10 +1497,153 @@ rstto_main_window_image_list_iter_changed (RsttoMainWindow *window)
     }
 }
 
+/**
+ * rstto_main_window_update_open_with_menu:
+ * @window:
+ * @menu: One of the open-with menus
+ *
+ * Fill @menu with the applications for the current image. This is
+ * done when the menu is shown, not every time the image changes.
+ */
+static void
+rstto_main_window_update_open_with_menu (
+        RsttoMainWindow *window,
+        GtkWidget *menu)
+{
+    RsttoFile *cur_file = NULL;
+    GList *app_list, *iter;
+    const gchar *content_type;
+    const gchar *editor;
+    const gchar *id;
+    GtkWidget *menu_item = NULL;
+    GAppInfo *app_info = NULL;
+
+    iter = gtk_container_get_children (GTK_CONTAINER (menu));
+    g_list_foreach (iter, (GFunc)gtk_widget_destroy, NULL);
+    g_list_free (iter);
+
+    if (NULL != window->priv->iter)
+    {
+        cur_file = rstto_image_list_iter_get_file (window->priv->iter);
+    }
+
+    if (NULL == cur_file)
+    {
+        menu_item = gtk_image_menu_item_new_with_label (_("Empty"));
+        gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+        gtk_widget_set_sensitive (menu_item, FALSE);
+
+        gtk_widget_show_all (menu);
+        return;
+    }
+
+    content_type = rstto_file_get_content_type (cur_file);
+    app_list = rstto_main_window_get_app_list (window, content_type);
+    editor = rstto_mime_db_lookup (window->priv->db, content_type);
+
+    if (editor)
+    {
+        for (iter = app_list; iter; iter = g_list_next (iter))
+        {
+            if (0 == strcmp (g_app_info_get_id (iter->data), editor))
+            {
+                app_info = g_object_ref (iter->data);
+                break;
+            }
+        }
+
+        /* The editor does not have to be registered for the type */
+        if (NULL == app_info)
+        {
+            app_info = (GAppInfo *) g_desktop_app_info_new (editor);
+        }
+
+        if ( app_info != NULL )
+        {
+            menu_item = rstto_app_menu_item_new (app_info, rstto_file_get_file (cur_file));
+            gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+
+            menu_item = gtk_separator_menu_item_new ();
+            gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+
+            g_object_unref (app_info);
+        }
+    }
+
+    if (NULL != app_list)
+    {
+        for (iter = app_list; iter; iter = g_list_next (iter))
+        {
+            id = g_app_info_get_id (iter->data);
+            if (strcmp (id, RISTRETTO_DESKTOP_ID))
+            {
+                if ((!editor) || (editor && strcmp (id, editor)))
+                {
+                    menu_item = rstto_app_menu_item_new (iter->data, rstto_file_get_file (cur_file));
+                    gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+                }
+            }
+        }
+
+        menu_item = gtk_separator_menu_item_new ();
+        gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+    }
+
+    menu_item = gtk_menu_item_new_with_mnemonic (_("Open With Other _Application..."));
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
+    g_signal_connect(G_OBJECT(menu_item), "activate", G_CALLBACK(cb_rstto_main_window_open_with_other_app), window);
+
+    gtk_widget_show_all (menu);
+}
+
+/**
+ * rstto_main_window_get_app_list:
+ * @window:
+ * @content_type:
+ *
+ * Looking up the applications for a content-type reads the desktop-file
+ * database, the result is kept until an application is (un)installed.
+ * Without GAppInfoMonitor there is no way to tell, the list is only
+ * reused while a menu is filled.
+ *
+ * Return value: List of GAppInfos, owned by @window
+ */
+static GList *
+rstto_main_window_get_app_list (
+        RsttoMainWindow *window,
+        const gchar *content_type)
+{
+    gpointer app_list = NULL;
+
+    if (FALSE == g_hash_table_lookup_extended (
+            window->priv->app_lists,
+            content_type,
+            NULL,
+            &app_list))
+    {
+        app_list = g_app_info_get_all_for_type (content_type);
+        g_hash_table_insert (
+                window->priv->app_lists,
+                g_strdup (content_type),
+                app_list);
+    }
+
+    return app_list;
+}
+
+static void
+rstto_main_window_free_app_list (gpointer app_list)
+{
+    g_list_foreach (app_list, (GFunc)g_object_unref, NULL);
+    g_list_free (app_list);
+}
+
 /**
  * rstto_main_window_update_statusbar:
  * @window:
  *
+ * The EXIF-values come from the metadata of the file, which is read
+ * in the background. They are added when "metadata-ready" is emitted.
  */
 static void
 rstto_main_window_update_statusbar (RsttoMainWindow *window)
@@ -1416,13 +1653,18 @@ rstto_main_window_update_statusbar (RsttoMainWindow *window)
     gchar *tmp_status = NULL;
     RsttoFile *cur_file = NULL;
     RsttoImageViewer *viewer = RSTTO_IMAGE_VIEWER(window->priv->image_viewer);
-    ExifEntry *exif_entry = NULL;
-    gchar exif_data[20];
+    gdouble f_number;
+    gdouble exposure_time;
     GError *error = NULL;
 
+    g_free (window->priv->statusbar_text);
+    window->priv->statusbar_text = NULL;
+
     if (window->priv->image_list)
     {
         cur_file = rstto_image_list_iter_get_file (window->priv->iter);
+        rstto_main_window_set_metadata_file (window, cur_file);
+
         if (NULL != cur_file)
         {
             file_basename = rstto_file_get_display_name (cur_file);
@@ -1444,49 +1686,38 @@ rstto_main_window_update_statusbar (RsttoMainWindow *window)
             else
             {
                 gtk_widget_hide (window->priv->warning);
-                if (TRUE == rstto_file_has_exif (cur_file))
-                {
-                    /* Extend the status-message with exif-info */
-                    /********************************************/
-                    exif_entry = rstto_file_get_exif (
-                            cur_file,
-                            EXIF_TAG_FNUMBER);
-                    if (exif_entry)
-                    {
-                        exif_entry_get_value (exif_entry, exif_data, 20);
 
-                        tmp_status = g_strdup_printf ("%s\t%s", status, exif_data);
-
-                        g_free (status);
-                        status = tmp_status;
+                /* Extend the status-message with exif-info, in the
+                 * format of libexif.
+                 */
+                f_number = rstto_file_get_f_number (cur_file);
+                if (f_number > 0)
+                {
+                    tmp_status = g_strdup_printf ("%s\tf/%.01f", status, f_number);
+                    g_free (status);
+                    status = tmp_status;
+                }
 
-                        /*exif_entry_free (exif_entry);*/
+                exposure_time = rstto_file_get_exposure_time (cur_file);
+                if (exposure_time > 0)
+                {
+                    if (exposure_time < 1)
+                    {
+                        tmp_status = g_strdup_printf (_("%s\t1/%.0f sec."), status, 1.0 / exposure_time);
                     }
-                    exif_entry = rstto_file_get_exif (
-                            cur_file,
-                            EXIF_TAG_EXPOSURE_TIME);
-                    if (exif_entry)
+                    else
                     {
-                        exif_entry_get_value (exif_entry, exif_data, 20);
-
-                        tmp_status = g_strdup_printf ("%s\t%s", status, exif_data);
-
-                        g_free (status);
-                        status = tmp_status;
-
-                        /*exif_entry_free (exif_entry);*/
+                        tmp_status = g_strdup_printf (_("%s\t%.0f sec."), status, exposure_time);
                     }
+                    g_free (status);
+                    status = tmp_status;
                 }
 
                 if(rstto_image_viewer_get_width(viewer) != 0 && rstto_image_viewer_get_height(viewer) != 0)
                 {
-                    tmp_status = g_strdup_printf ("%s\t%d x %d\t%.1f%%", status,
+                    window->priv->statusbar_text = g_strdup_printf ("%s\t%d x %d", status,
                                                 rstto_image_viewer_get_width(viewer),
-                                                rstto_image_viewer_get_height(viewer),
-                                                (100 * rstto_image_viewer_get_scale(viewer)));
-
-                    g_free (status);
-                    status = tmp_status;
+                                                rstto_image_viewer_get_height(viewer));
                 }
             }
         }
@@ -1503,6 +1734,16 @@ rstto_main_window_update_statusbar (RsttoMainWindow *window)
                 g_free (status);
             }
             status = g_strdup (_("Loading..."));
+
+            g_free (window->priv->statusbar_text);
+            window->priv->statusbar_text = NULL;
+        }
+
+        if (NULL != window->priv->statusbar_text)
+        {
+            g_free (status);
+            rstto_main_window_update_statusbar_scale (window);
+            return;
         }
 
         gtk_statusbar_pop (GTK_STATUSBAR (window->priv->statusbar), window->priv->statusbar_context_id);
@@ -1518,6 +1759,73 @@ rstto_main_window_update_statusbar (RsttoMainWindow *window)
 
 }
 
+/**
+ * rstto_main_window_update_statusbar_scale:
+ * @window:
+ *
+ * Only replace the zoom-level in the statusbar.
+ */
+static void
+rstto_main_window_update_statusbar_scale (RsttoMainWindow *window)
+{
+    RsttoImageViewer *viewer = RSTTO_IMAGE_VIEWER(window->priv->image_viewer);
+    gchar *status;
+
+    if (NULL == window->priv->statusbar_text)
+    {
+        rstto_main_window_update_statusbar (window);
+        return;
+    }
+
+    status = g_strdup_printf ("%s\t%.1f%%",
+            window->priv->statusbar_text,
+            (100 * rstto_image_viewer_get_scale(viewer)));
+
+    gtk_statusbar_pop (GTK_STATUSBAR (window->priv->statusbar), window->priv->statusbar_context_id);
+    gtk_statusbar_push (GTK_STATUSBAR (window->priv->statusbar), window->priv->statusbar_context_id, status);
+    g_free (status);
+}
+
+/**
+ * rstto_main_window_set_metadata_file:
+ * @window:
+ * @r_file: The file shown in the statusbar, or NULL
+ *
+ * Wait for the metadata of @r_file if it has not been read yet.
+ */
+static void
+rstto_main_window_set_metadata_file (
+        RsttoMainWindow *window,
+        RsttoFile *r_file)
+{
+    if (r_file == window->priv->metadata_file)
+    {
+        return;
+    }
+
+    if (NULL != window->priv->metadata_file)
+    {
+        g_signal_handlers_disconnect_by_func (
+                window->priv->metadata_file,
+                cb_rstto_main_window_metadata_ready,
+                window);
+        g_object_unref (window->priv->metadata_file);
+        window->priv->metadata_file = NULL;
+    }
+
+    if ( (NULL != r_file) &&
+         (FALSE == rstto_file_has_metadata (r_file)) )
+    {
+        window->priv->metadata_file = g_object_ref (r_file);
+        g_signal_connect (
+                G_OBJECT (r_file),
+                "metadata-ready",
+                G_CALLBACK (cb_rstto_main_window_metadata_ready),
+                window);
+        rstto_file_load_metadata (r_file);
+    }
+}
+
 /**
  * rstto_main_window_update_buttons:
  * @window:
@@ -2042,6 +2350,24 @@ cb_rstto_main_window_image_list_iter_changed (RsttoImageListIter *iter, RsttoMai
     rstto_main_window_image_list_iter_changed (window);
 }
 
+static void
+cb_rstto_main_window_open_with_menu_show (GtkWidget *menu, RsttoMainWindow *window)
+{
+    rstto_main_window_update_open_with_menu (window, menu);
+
+#if !GLIB_CHECK_VERSION (2, 40, 0)
+    g_hash_table_remove_all (window->priv->app_lists);
+#endif
+}
+
+#if GLIB_CHECK_VERSION (2, 40, 0)
+static void
+cb_rstto_main_window_app_info_changed (GAppInfoMonitor *monitor, RsttoMainWindow *window)
+{
+    g_hash_table_remove_all (window->priv->app_lists);
+}
+#endif
+
 static void
 cb_rstto_main_window_sorting_function_changed (GtkRadioAction *action, GtkRadioAction *current,  RsttoMainWindow *window)
 {
@@ -2518,31 +2844,226 @@ cb_rstto_main_window_pause (GtkWidget *widget, RsttoMainWindow *window)
             window->priv->toolbar_pause_merge_id);
 
     window->priv->playing = FALSE;
+    window->priv->play_waiting = FALSE;
+
+    if (window->priv->play_timeout_id)
+    {
+        g_source_remove (window->priv->play_timeout_id);
+        window->priv->play_timeout_id = 0;
+    }
+
+    /* Do not keep a decoded slide around while paused */
+    rstto_image_viewer_preload_file (
+            RSTTO_IMAGE_VIEWER (window->priv->image_viewer),
+            NULL);
 }
 
 /**
  * cb_rstto_main_window_play_slideshow:
  * @window:
  *
+ * Start preloading the next slide, or show it when it is due.
  */
 static gboolean
 cb_rstto_main_window_play_slideshow (RsttoMainWindow *window)
 {
-    if (window->priv->playing)
+    RsttoImageViewer *viewer = RSTTO_IMAGE_VIEWER (window->priv->image_viewer);
+    RsttoFile *r_file;
+
+    window->priv->play_timeout_id = 0;
+
+    if (FALSE == window->priv->playing)
     {
-        /* Check if we could navigate forward, if not, wrapping is
-         * disabled and we should force the iter to position 0
-         */
-        if (rstto_image_list_iter_next (window->priv->iter) == FALSE)
-        {
-            rstto_image_list_iter_set_position (window->priv->iter, 0);
-        }
+        return FALSE;
+    }
+
+    /* The list can change while the slideshow is playing, make sure
+     * the file that is preloaded is still the next one.
+     */
+    r_file = rstto_main_window_get_next_slide (window);
+    if (window->priv->play_preload_time < 0)
+    {
+        window->priv->play_preload_time = g_timer_elapsed (window->priv->play_timer, NULL);
+    }
+    rstto_image_viewer_preload_file (viewer, r_file);
+
+    if (window->priv->play_deadline > g_timer_elapsed (window->priv->play_timer, NULL))
+    {
+        rstto_main_window_schedule_slideshow (window);
+    }
+    else if ( (NULL == r_file) ||
+              (TRUE == rstto_image_viewer_is_preloaded (viewer, r_file)) )
+    {
+        rstto_main_window_next_slide (window);
     }
     else
     {
-        window->priv->play_timeout_id  = 0;
+        /* Late, show the slide as soon as it is loaded */
+        window->priv->play_waiting = TRUE;
+        window->priv->play_timeout_id = g_timeout_add (
+                RSTTO_SLIDESHOW_WAIT_INTERVAL,
+                (GSourceFunc)cb_rstto_main_window_play_slideshow,
+                window);
+    }
+
+    if (NULL != r_file)
+    {
+        g_object_unref (r_file);
+    }
+
+    return FALSE;
+}
+
+static void
+cb_rstto_main_window_preload_ready (
+        GtkWidget *widget,
+        RsttoMainWindow *window)
+{
+    gdouble load_time;
+
+    if ( (FALSE == window->priv->playing) ||
+         (window->priv->play_preload_time < 0) )
+    {
+        return;
+    }
+
+    /* Keep a moving average, one slow image should not
+     * start every following preload early.
+     */
+    load_time = g_timer_elapsed (window->priv->play_timer, NULL) - window->priv->play_preload_time;
+    if (window->priv->play_load_time > 0)
+    {
+        window->priv->play_load_time = (3 * window->priv->play_load_time + load_time) / 4;
+    }
+    else
+    {
+        window->priv->play_load_time = load_time;
+    }
+
+    if (TRUE == window->priv->play_waiting)
+    {
+        rstto_main_window_next_slide (window);
     }
-    return window->priv->playing;
+}
+
+/**
+ * rstto_main_window_schedule_slideshow:
+ * @window:
+ *
+ * Wake up when the next slide has to be preloaded, or when it is due.
+ */
+static void
+rstto_main_window_schedule_slideshow (RsttoMainWindow *window)
+{
+    gdouble lookahead = MAX (RSTTO_SLIDESHOW_MIN_LOOKAHEAD, 2 * window->priv->play_load_time);
+    gdouble next = window->priv->play_deadline;
+
+    if (window->priv->play_preload_time < 0)
+    {
+        next -= MIN (lookahead, window->priv->play_interval);
+    }
+
+    next -= g_timer_elapsed (window->priv->play_timer, NULL);
+
+    window->priv->play_timeout_id = g_timeout_add (
+            (guint)(MAX (0, next) * 1000),
+            (GSourceFunc)cb_rstto_main_window_play_slideshow,
+            window);
+}
+
+/**
+ * rstto_main_window_next_slide:
+ * @window:
+ *
+ * Show the next slide, and schedule the one after it. The deadlines
+ * are kept on a fixed interval, unless a slide was late; then the
+ * slide is shown for the full interval.
+ */
+static void
+rstto_main_window_next_slide (RsttoMainWindow *window)
+{
+    gdouble now;
+
+    window->priv->play_waiting = FALSE;
+
+    if (window->priv->play_timeout_id)
+    {
+        g_source_remove (window->priv->play_timeout_id);
+        window->priv->play_timeout_id = 0;
+    }
+
+    /* Check if we could navigate forward, if not, wrapping is
+     * disabled and we should force the iter to position 0
+     */
+    if (rstto_image_list_iter_next (window->priv->iter) == FALSE)
+    {
+        rstto_image_list_iter_set_position (window->priv->iter, 0);
+    }
+
+    now = g_timer_elapsed (window->priv->play_timer, NULL);
+    window->priv->play_deadline = MAX (window->priv->play_deadline, now) + window->priv->play_interval;
+    window->priv->play_preload_time = -1;
+
+    rstto_main_window_schedule_slideshow (window);
+}
+
+/**
+ * rstto_main_window_restart_slide:
+ * @window:
+ *
+ * A slide that was chosen by hand while the slideshow is playing is
+ * shown for the full interval.
+ */
+static void
+rstto_main_window_restart_slide (RsttoMainWindow *window)
+{
+    if (FALSE == window->priv->playing)
+    {
+        return;
+    }
+
+    window->priv->play_waiting = FALSE;
+
+    if (window->priv->play_timeout_id)
+    {
+        g_source_remove (window->priv->play_timeout_id);
+        window->priv->play_timeout_id = 0;
+    }
+
+    window->priv->play_deadline = g_timer_elapsed (window->priv->play_timer, NULL) +
+            window->priv->play_interval;
+    window->priv->play_preload_time = -1;
+
+    rstto_main_window_schedule_slideshow (window);
+}
+
+/**
+ * rstto_main_window_get_next_slide:
+ * @window:
+ *
+ * Return value: The file after the current one, or NULL. The caller
+ *               owns a reference.
+ */
+static RsttoFile *
+rstto_main_window_get_next_slide (RsttoMainWindow *window)
+{
+    RsttoImageListIter *iter = rstto_image_list_iter_clone (window->priv->iter);
+    RsttoFile *r_file;
+
+    if (rstto_image_list_iter_next (iter) == FALSE)
+    {
+        rstto_image_list_iter_set_position (iter, 0);
+    }
+
+    r_file = rstto_image_list_iter_get_file (iter);
+    if (NULL != r_file)
+    {
+        g_object_ref (r_file);
+    }
+
+    g_object_unref (iter);
+
+    return r_file;
 }
 
 /**
@@ -2688,6 +3209,21 @@ cb_rstto_main_window_update_statusbar (GtkWidget *widget, RsttoMainWindow *windo
     rstto_main_window_update_statusbar(window);
 }
 
+static void
+cb_rstto_main_window_scale_changed (GtkWidget *widget, RsttoMainWindow *window)
+{
+    rstto_main_window_update_statusbar_scale (window);
+}
+
+static void
+cb_rstto_main_window_metadata_ready (RsttoFile *r_file, RsttoMainWindow *window)
+{
+    if (r_file == rstto_image_list_iter_get_file (window->priv->iter))
+    {
+        rstto_main_window_update_statusbar (window);
+    }
+}
+
 /******************/
 /* ZOOM CALLBACKS */
 /******************/
@@ -2857,6 +3393,7 @@ static void
 cb_rstto_main_window_next_image (GtkWidget *widget, RsttoMainWindow *window)
 {
     rstto_image_list_iter_next (window->priv->iter);
+    rstto_main_window_restart_slide (window);
 }
 
 /**
@@ -2871,6 +3408,7 @@ static void
 cb_rstto_main_window_previous_image (GtkWidget *widget, RsttoMainWindow *window)
 {
     rstto_image_list_iter_previous (window->priv->iter);
+    rstto_main_window_restart_slide (window);
 }
 
 /**
@@ -4170,11 +4708,27 @@ rstto_main_window_play_slideshow (RsttoMainWindow *window)
             "slideshow-timeout",
             &timeout);
 
+    if (window->priv->play_timeout_id)
+    {
+        g_source_remove (window->priv->play_timeout_id);
+    }
+
+    if (NULL == window->priv->play_timer)
+    {
+        window->priv->play_timer = g_timer_new ();
+    }
+    else
+    {
+        g_timer_start (window->priv->play_timer);
+    }
+
     window->priv->playing = TRUE;
-    window->priv->play_timeout_id = g_timeout_add (
-            g_value_get_uint (&timeout)*1000,
-            (GSourceFunc)cb_rstto_main_window_play_slideshow,
-            window);
+    window->priv->play_interval = g_value_get_uint (&timeout);
+    window->priv->play_deadline = window->priv->play_interval;
+    window->priv->play_preload_time = -1;
+    window->priv->play_waiting = FALSE;
+
+    rstto_main_window_schedule_slideshow (window);
     return TRUE;
 }
 
@@ -4226,3 +4780,24 @@ cb_rstto_thumbnailer_ready(
         }
     } 
 }
+
+static void
+cb_rstto_thumbnail_loader_ready (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *file,
+        guint size,
+        gpointer user_data)
+{
+    RsttoMainWindow *window = RSTTO_MAIN_WINDOW (user_data);
+    RsttoFile *cur_file = rstto_image_list_iter_get_file (window->priv->iter);
+    const GdkPixbuf *pixbuf = NULL;
+
+    if ( (file == cur_file) && (size == THUMBNAIL_SIZE_SMALL) )
+    {
+        pixbuf = rstto_file_peek_thumbnail (file, THUMBNAIL_SIZE_SMALL);
+        if (pixbuf != NULL)
+        {
+            gtk_window_set_icon (GTK_WINDOW (window), gdk_pixbuf_copy(pixbuf));
+        }
+    }
+}
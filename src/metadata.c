@@ -0,0 +1,672 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  A minimal EXIF reader, it only reads the JPEG/TIFF headers and the
+ *  few tags that are needed to list and display an image, and the ones
+ *  shown in the statusbar. Use libexif
+ *  (rstto_file_get_exif) for everything else.
+ *
+ *  The functions in this file do not touch any shared state, they can
+ *  be called from a worker-thread.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "util.h"
+#include "metadata.h"
+
+/* An APP1 segment can not be larger than this */
+#define RSTTO_METADATA_MAX_SEGMENT 65535
+
+/* Stop looking for the EXIF/SOF segments after this many segments */
+#define RSTTO_METADATA_MAX_SEGMENTS 32
+
+#define TIFF_TYPE_ASCII 2
+#define TIFF_TYPE_SHORT 3
+#define TIFF_TYPE_LONG  4
+#define TIFF_TYPE_RATIONAL 5
+
+#define TIFF_TAG_MODEL              0x0110
+#define TIFF_TAG_ORIENTATION        0x0112
+#define TIFF_TAG_JPEG_OFFSET        0x0201
+#define TIFF_TAG_JPEG_LENGTH        0x0202
+#define TIFF_TAG_EXIF_IFD_POINTER   0x8769
+#define EXIF_TAG_EXPOSURE_TIME      0x829A
+#define EXIF_TAG_FNUMBER            0x829D
+#define EXIF_TAG_DATE_TIME_ORIGINAL 0x9003
+#define EXIF_TAG_PIXEL_X_DIMENSION  0xA002
+#define EXIF_TAG_PIXEL_Y_DIMENSION  0xA003
+
+static guint16
+read_u16 (const guchar *data, gboolean big_endian)
+{
+    if (big_endian)
+    {
+        return (data[0] << 8) | data[1];
+    }
+    return (data[1] << 8) | data[0];
+}
+
+static guint32
+read_u32 (const guchar *data, gboolean big_endian)
+{
+    if (big_endian)
+    {
+        return ((guint32)data[0] << 24) | ((guint32)data[1] << 16) |
+               ((guint32)data[2] << 8)  |  (guint32)data[3];
+    }
+    return ((guint32)data[3] << 24) | ((guint32)data[2] << 16) |
+           ((guint32)data[1] << 8)  |  (guint32)data[0];
+}
+
+static gchar *
+rstto_metadata_get_string (
+        const guchar *tiff,
+        gsize length,
+        const guchar *entry,
+        gboolean big_endian)
+{
+    const guchar *data;
+    guint32 count = read_u32 (entry + 4, big_endian);
+    guint32 offset;
+    gchar *str;
+
+    if ( (read_u16 (entry + 2, big_endian) != TIFF_TYPE_ASCII) ||
+         (count == 0) )
+    {
+        return NULL;
+    }
+
+    /* Values of up to 4 bytes are stored in the entry itself */
+    if (count <= 4)
+    {
+        data = entry + 8;
+    }
+    else
+    {
+        offset = read_u32 (entry + 8, big_endian);
+        if ( (offset > length) || (count > length - offset) )
+        {
+            return NULL;
+        }
+        data = tiff + offset;
+    }
+
+    str = g_strndup ((const gchar *)data, count);
+    g_strstrip (str);
+
+    if ( ('\0' == str[0]) ||
+         (FALSE == g_utf8_validate (str, -1, NULL)) )
+    {
+        g_free (str);
+        return NULL;
+    }
+
+    return str;
+}
+
+static guint32
+rstto_metadata_get_uint (
+        const guchar *entry,
+        gboolean big_endian)
+{
+    switch (read_u16 (entry + 2, big_endian))
+    {
+        case TIFF_TYPE_SHORT:
+            return read_u16 (entry + 8, big_endian);
+        case TIFF_TYPE_LONG:
+            return read_u32 (entry + 8, big_endian);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * rstto_metadata_get_rational:
+ * @tiff:
+ * @length:
+ * @entry:
+ * @big_endian:
+ *
+ * Return value: The value of a single unsigned rational, 0 if it
+ *               is invalid.
+ */
+static gdouble
+rstto_metadata_get_rational (
+        const guchar *tiff,
+        gsize length,
+        const guchar *entry,
+        gboolean big_endian)
+{
+    guint32 offset;
+    guint32 denominator;
+
+    if ( (read_u16 (entry + 2, big_endian) != TIFF_TYPE_RATIONAL) ||
+         (read_u32 (entry + 4, big_endian) != 1) )
+    {
+        return 0;
+    }
+
+    /* A rational is 8 bytes, it is never stored in the entry itself */
+    offset = read_u32 (entry + 8, big_endian);
+    if ( (offset > length) || (8 > length - offset) )
+    {
+        return 0;
+    }
+
+    denominator = read_u32 (tiff + offset + 4, big_endian);
+    if (0 == denominator)
+    {
+        return 0;
+    }
+
+    return (gdouble)read_u32 (tiff + offset, big_endian) / denominator;
+}
+
+/**
+ * rstto_metadata_parse_date:
+ * @date: "YYYY:MM:DD HH:MM:SS", in local time
+ *
+ */
+static gint64
+rstto_metadata_parse_date (const gchar *date)
+{
+    struct tm tm;
+    time_t t;
+
+    memset (&tm, 0, sizeof (struct tm));
+
+    if (sscanf (date, "%4d:%2d:%2d %2d:%2d:%2d",
+            &tm.tm_year,
+            &tm.tm_mon,
+            &tm.tm_mday,
+            &tm.tm_hour,
+            &tm.tm_min,
+            &tm.tm_sec) != 6)
+    {
+        return 0;
+    }
+
+    /* Cameras write 0000:00:00 00:00:00 if the clock is not set */
+    if (tm.tm_year < 1900)
+    {
+        return 0;
+    }
+
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+
+    t = mktime (&tm);
+    if (t == (time_t)-1)
+    {
+        return 0;
+    }
+
+    return (gint64)t;
+}
+
+static void
+rstto_metadata_parse_ifd (
+        const guchar *tiff,
+        gsize length,
+        guint32 offset,
+        gboolean big_endian,
+        RsttoMetadata *metadata,
+        guint32 *exif_ifd)
+{
+    const guchar *entry;
+    gchar *str;
+    guint32 value;
+    guint n_entries;
+    guint i;
+
+    if ( (offset < 8) || (offset > length - 2) )
+    {
+        return;
+    }
+
+    n_entries = read_u16 (tiff + offset, big_endian);
+    if (n_entries > (length - offset - 2) / 12)
+    {
+        n_entries = (length - offset - 2) / 12;
+    }
+
+    for (i = 0; i < n_entries; ++i)
+    {
+        entry = tiff + offset + 2 + (i * 12);
+
+        switch (read_u16 (entry, big_endian))
+        {
+            case TIFF_TAG_ORIENTATION:
+                value = rstto_metadata_get_uint (entry, big_endian);
+                if ( (value >= RSTTO_IMAGE_ORIENT_NONE) &&
+                     (value <= RSTTO_IMAGE_ORIENT_270) )
+                {
+                    metadata->orientation = value;
+                }
+                break;
+            case TIFF_TAG_MODEL:
+                if (NULL == metadata->model)
+                {
+                    metadata->model = rstto_metadata_get_string (
+                            tiff,
+                            length,
+                            entry,
+                            big_endian);
+                }
+                break;
+            case TIFF_TAG_EXIF_IFD_POINTER:
+                if (NULL != exif_ifd)
+                {
+                    *exif_ifd = rstto_metadata_get_uint (entry, big_endian);
+                }
+                break;
+            case EXIF_TAG_DATE_TIME_ORIGINAL:
+                str = rstto_metadata_get_string (tiff, length, entry, big_endian);
+                if (NULL != str)
+                {
+                    metadata->capture_time = rstto_metadata_parse_date (str);
+                    g_free (str);
+                }
+                break;
+            case EXIF_TAG_FNUMBER:
+                metadata->f_number = rstto_metadata_get_rational (
+                        tiff,
+                        length,
+                        entry,
+                        big_endian);
+                break;
+            case EXIF_TAG_EXPOSURE_TIME:
+                metadata->exposure_time = rstto_metadata_get_rational (
+                        tiff,
+                        length,
+                        entry,
+                        big_endian);
+                break;
+            case EXIF_TAG_PIXEL_X_DIMENSION:
+                if (0 == metadata->width)
+                {
+                    metadata->width = rstto_metadata_get_uint (entry, big_endian);
+                }
+                break;
+            case EXIF_TAG_PIXEL_Y_DIMENSION:
+                if (0 == metadata->height)
+                {
+                    metadata->height = rstto_metadata_get_uint (entry, big_endian);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * rstto_metadata_parse_thumbnail:
+ * @tiff:
+ * @length:
+ * @offset: offset of IFD1
+ * @big_endian:
+ * @thumbnail: Return location for the JPEG-data, points into @tiff
+ * @thumbnail_length:
+ *
+ * IFD1 describes the embedded thumbnail, a small JPEG image.
+ */
+static void
+rstto_metadata_parse_thumbnail (
+        const guchar *tiff,
+        gsize length,
+        guint32 offset,
+        gboolean big_endian,
+        const guchar **thumbnail,
+        gsize *thumbnail_length)
+{
+    const guchar *entry;
+    guint32 jpeg_offset = 0;
+    guint32 jpeg_length = 0;
+    guint n_entries;
+    guint i;
+
+    if ( (offset < 8) || (offset > length - 2) )
+    {
+        return;
+    }
+
+    n_entries = read_u16 (tiff + offset, big_endian);
+    if (n_entries > (length - offset - 2) / 12)
+    {
+        n_entries = (length - offset - 2) / 12;
+    }
+
+    for (i = 0; i < n_entries; ++i)
+    {
+        entry = tiff + offset + 2 + (i * 12);
+
+        switch (read_u16 (entry, big_endian))
+        {
+            case TIFF_TAG_JPEG_OFFSET:
+                jpeg_offset = rstto_metadata_get_uint (entry, big_endian);
+                break;
+            case TIFF_TAG_JPEG_LENGTH:
+                jpeg_length = rstto_metadata_get_uint (entry, big_endian);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if ( (jpeg_offset == 0) || (jpeg_length == 0) ||
+         (jpeg_offset > length) || (jpeg_length > length - jpeg_offset) )
+    {
+        return;
+    }
+
+    *thumbnail = tiff + jpeg_offset;
+    *thumbnail_length = jpeg_length;
+}
+
+static gboolean
+rstto_metadata_parse_tiff (
+        const guchar *tiff,
+        gsize length,
+        RsttoMetadata *metadata,
+        const guchar **thumbnail,
+        gsize *thumbnail_length)
+{
+    gboolean big_endian;
+    guint32 exif_ifd = 0;
+    guint32 ifd0;
+    guint32 ifd1_pointer;
+
+    if (length < 8)
+    {
+        return FALSE;
+    }
+
+    if ( (tiff[0] == 'M') && (tiff[1] == 'M') )
+    {
+        big_endian = TRUE;
+    }
+    else if ( (tiff[0] == 'I') && (tiff[1] == 'I') )
+    {
+        big_endian = FALSE;
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    if (read_u16 (tiff + 2, big_endian) != 42)
+    {
+        return FALSE;
+    }
+
+    ifd0 = read_u32 (tiff + 4, big_endian);
+    rstto_metadata_parse_ifd (
+            tiff,
+            length,
+            ifd0,
+            big_endian,
+            metadata,
+            &exif_ifd);
+
+    /* The offset of IFD1 follows the entries of IFD0 */
+    if ( (NULL != thumbnail) &&
+         (ifd0 >= 8) && (ifd0 <= length - 2) )
+    {
+        ifd1_pointer = ifd0 + 2 + (read_u16 (tiff + ifd0, big_endian) * 12);
+        if (ifd1_pointer <= length - 4)
+        {
+            rstto_metadata_parse_thumbnail (
+                    tiff,
+                    length,
+                    read_u32 (tiff + ifd1_pointer, big_endian),
+                    big_endian,
+                    thumbnail,
+                    thumbnail_length);
+        }
+    }
+
+    if (0 != exif_ifd)
+    {
+        rstto_metadata_parse_ifd (
+                tiff,
+                length,
+                exif_ifd,
+                big_endian,
+                metadata,
+                NULL);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+rstto_metadata_read_jpeg (
+        FILE *fp,
+        RsttoMetadata *metadata,
+        guchar **thumbnail,
+        gsize *thumbnail_length)
+{
+    const guchar *embedded = NULL;
+    gsize embedded_length = 0;
+    guchar header[5];
+    guchar *segment;
+    gboolean found = FALSE;
+    gint marker;
+    guint length;
+    guint i;
+
+    for (i = 0; i < RSTTO_METADATA_MAX_SEGMENTS; ++i)
+    {
+        /* Markers may be padded with any number of 0xFF bytes */
+        marker = fgetc (fp);
+        if (marker != 0xFF)
+        {
+            break;
+        }
+        while (marker == 0xFF)
+        {
+            marker = fgetc (fp);
+        }
+
+        if ( (marker == EOF) ||
+             (marker == 0xD9) || /* EOI */
+             (marker == 0xDA) )  /* SOS, the image-data follows */
+        {
+            break;
+        }
+
+        /* Markers without a length */
+        if ( (marker == 0x01) ||
+             ((marker >= 0xD0) && (marker <= 0xD7)) )
+        {
+            continue;
+        }
+
+        if (fread (header, 1, 2, fp) != 2)
+        {
+            break;
+        }
+        length = (header[0] << 8) | header[1];
+        if (length < 2)
+        {
+            break;
+        }
+        length -= 2;
+
+        if ( (marker == 0xE1) && (FALSE == found) )
+        {
+            segment = g_malloc (length);
+            if (fread (segment, 1, length, fp) != length)
+            {
+                g_free (segment);
+                break;
+            }
+            if ( (length > 6) &&
+                 (memcmp (segment, "Exif\0\0", 6) == 0) )
+            {
+                found = rstto_metadata_parse_tiff (
+                        segment + 6,
+                        length - 6,
+                        metadata,
+                        (NULL != thumbnail) ? &embedded : NULL,
+                        &embedded_length);
+            }
+            if (NULL != embedded)
+            {
+                /* The thumbnail points into the segment */
+                *thumbnail = g_memdup (embedded, embedded_length);
+                *thumbnail_length = embedded_length;
+            }
+            g_free (segment);
+            continue;
+        }
+
+        /* SOFn, except DHT (C4), JPG (C8) and DAC (CC) */
+        if ( (marker >= 0xC0) && (marker <= 0xCF) &&
+             (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC) )
+        {
+            if ( (length >= 5) &&
+                 (fread (header, 1, 5, fp) == 5) )
+            {
+                /* The frame-header is authoritative */
+                metadata->height = (header[1] << 8) | header[2];
+                metadata->width = (header[3] << 8) | header[4];
+                found = TRUE;
+            }
+
+            /* The EXIF segment precedes the frame */
+            break;
+        }
+
+        if (fseek (fp, length, SEEK_CUR) != 0)
+        {
+            break;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * rstto_metadata_read:
+ * @path: local path of the image
+ * @metadata: Metadata to fill, call rstto_metadata_clear to free it
+ *
+ * Read the metadata from the headers of a JPEG or TIFF image.
+ *
+ * Return value: TRUE if any metadata was found.
+ */
+gboolean
+rstto_metadata_read (
+        const gchar *path,
+        RsttoMetadata *metadata)
+{
+    return rstto_metadata_read_thumbnail (path, metadata, NULL, NULL);
+}
+
+/**
+ * rstto_metadata_read_thumbnail:
+ * @path: local path of the image
+ * @metadata: Metadata to fill, call rstto_metadata_clear to free it
+ * @thumbnail: Return location for the embedded thumbnail of a JPEG
+ *             image, free it with g_free. Set to NULL if there is none.
+ * @thumbnail_length:
+ *
+ * Like rstto_metadata_read, the embedded thumbnail (usually 160x120)
+ * is in the same segment as the metadata.
+ *
+ * Return value: TRUE if any metadata was found.
+ */
+gboolean
+rstto_metadata_read_thumbnail (
+        const gchar *path,
+        RsttoMetadata *metadata,
+        guchar **thumbnail,
+        gsize *thumbnail_length)
+{
+    FILE *fp;
+    guchar *buffer;
+    guchar magic[4];
+    gsize length;
+    gboolean ret_val = FALSE;
+
+    memset (metadata, 0, sizeof (RsttoMetadata));
+
+    if (NULL != thumbnail)
+    {
+        *thumbnail = NULL;
+        *thumbnail_length = 0;
+    }
+
+    fp = g_fopen (path, "rb");
+    if (NULL == fp)
+    {
+        return FALSE;
+    }
+
+    if (fread (magic, 1, 2, fp) == 2)
+    {
+        if ( (magic[0] == 0xFF) && (magic[1] == 0xD8) )
+        {
+            ret_val = rstto_metadata_read_jpeg (
+                    fp,
+                    metadata,
+                    thumbnail,
+                    thumbnail_length);
+        }
+        else if ( ((magic[0] == 'I') && (magic[1] == 'I')) ||
+                  ((magic[0] == 'M') && (magic[1] == 'M')) )
+        {
+            /* A TIFF file, the first IFD is normally at the start */
+            buffer = g_malloc (RSTTO_METADATA_MAX_SEGMENT);
+            buffer[0] = magic[0];
+            buffer[1] = magic[1];
+            length = 2 + fread (buffer + 2, 1, RSTTO_METADATA_MAX_SEGMENT - 2, fp);
+
+            ret_val = rstto_metadata_parse_tiff (
+                    buffer,
+                    length,
+                    metadata,
+                    NULL,
+                    NULL);
+            g_free (buffer);
+        }
+    }
+
+    fclose (fp);
+
+    return ret_val;
+}
+
+void
+rstto_metadata_clear (
+        RsttoMetadata *metadata)
+{
+    g_free (metadata->model);
+    memset (metadata, 0, sizeof (RsttoMetadata));
+}
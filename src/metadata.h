@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_METADATA_H__
+#define __RISTRETTO_METADATA_H__
+
+G_BEGIN_DECLS
+
+typedef struct _RsttoMetadata RsttoMetadata;
+
+struct _RsttoMetadata
+{
+    /* 0 if the orientation-tag is not set */
+    RsttoImageOrientation orientation;
+
+    /* DateTimeOriginal, seconds since the epoch, 0 if unknown */
+    gint64  capture_time;
+
+    /* Image dimensions, 0 if unknown */
+    gint    width;
+    gint    height;
+
+    /* Camera model, NULL if unknown */
+    gchar  *model;
+
+    /* Aperture and exposure time in seconds, 0 if unknown */
+    gdouble f_number;
+    gdouble exposure_time;
+};
+
+gboolean
+rstto_metadata_read (
+        const gchar *path,
+        RsttoMetadata *metadata);
+
+gboolean
+rstto_metadata_read_thumbnail (
+        const gchar *path,
+        RsttoMetadata *metadata,
+        guchar **thumbnail,
+        gsize *thumbnail_length);
+
+void
+rstto_metadata_clear (
+        RsttoMetadata *metadata);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_METADATA_H__ */
@@ -75,9 +75,10 @@ enum
     PROP_INVERT_ZOOM_DIRECTION,
     PROP_USE_THUNAR_PROPERTIES,
     PROP_MAXIMIZE_ON_STARTUP,
-    PROP_ERROR_MISSING_THUMBNAILER,
     PROP_SORT_TYPE,
     PROP_THUMBNAIL_SIZE,
+    PROP_USE_INTERNAL_THUMBNAILER,
+    PROP_THUMBNAIL_PREFETCH,
 };
 
 GType
@@ -130,12 +131,10 @@ struct _RsttoSettingsPriv
     gboolean  use_thunar_properties;
     gboolean  maximize_on_startup;
     RsttoThumbnailSize thumbnail_size;
+    gboolean  use_internal_thumbnailer;
+    guint     thumbnail_prefetch;
 
     RsttoSortType sort_type;
-
-    struct {
-        gboolean missing_thumbnailer;
-    } errors;
 };
 
 
@@ -187,8 +186,8 @@ rstto_settings_init (GObject *object)
     settings->priv->use_thunar_properties = TRUE;
     settings->priv->maximize_on_startup = TRUE;
     settings->priv->hide_thumbnails_fullscreen = TRUE;
-    settings->priv->errors.missing_thumbnailer = TRUE;
     settings->priv->thumbnail_size = THUMBNAIL_SIZE_NORMAL;
+    settings->priv->thumbnail_prefetch = 16;
 
     xfconf_g_property_bind (
             settings->priv->channel,
@@ -252,6 +251,13 @@ rstto_settings_init (GObject *object)
             settings,
             "thumbnail-size");
 
+    xfconf_g_property_bind (
+            settings->priv->channel,
+            "/window/thumbnails/prefetch",
+            G_TYPE_UINT,
+            settings,
+            "thumbnail-prefetch");
+
     xfconf_g_property_bind (
             settings->priv->channel,
             "/window/thumbnails/hide-fullscreen",
@@ -328,10 +334,10 @@ rstto_settings_init (GObject *object)
 
     xfconf_g_property_bind (
             settings->priv->channel,
-            "/errors/missing-thumbnailer",
+            "/thumbnailer/use-internal",
             G_TYPE_BOOLEAN,
             settings,
-            "show-error-missing-thumbnailer");
+            "use-internal-thumbnailer");
 
     xfconf_g_property_bind (
             settings->priv->channel,
@@ -573,17 +579,6 @@ rstto_settings_class_init (GObjectClass *object_class)
             PROP_MAXIMIZE_ON_STARTUP,
             pspec);
 
-    pspec = g_param_spec_boolean (
-            "show-error-missing-thumbnailer",
-            "",
-            "",
-            TRUE,
-            G_PARAM_READWRITE);
-    g_object_class_install_property (
-            object_class,
-            PROP_ERROR_MISSING_THUMBNAILER,
-            pspec);
-
     pspec = g_param_spec_uint (
             "sort-type",
             "",
@@ -609,6 +604,30 @@ rstto_settings_class_init (GObjectClass *object_class)
             object_class,
             PROP_THUMBNAIL_SIZE,
             pspec);
+
+    pspec = g_param_spec_boolean (
+            "use-internal-thumbnailer",
+            "",
+            "",
+            FALSE,
+            G_PARAM_READWRITE);
+    g_object_class_install_property (
+            object_class,
+            PROP_USE_INTERNAL_THUMBNAILER,
+            pspec);
+
+    pspec = g_param_spec_uint (
+            "thumbnail-prefetch",
+            "",
+            "",
+            0,
+            256,
+            16,
+            G_PARAM_READWRITE);
+    g_object_class_install_property (
+            object_class,
+            PROP_THUMBNAIL_PREFETCH,
+            pspec);
 }
 
 /**
@@ -768,15 +787,18 @@ rstto_settings_set_property    (GObject      *object,
         case PROP_MAXIMIZE_ON_STARTUP:
             settings->priv->maximize_on_startup = g_value_get_boolean (value);
             break;
-        case PROP_ERROR_MISSING_THUMBNAILER:
-            settings->priv->errors.missing_thumbnailer = g_value_get_boolean (value);
-            break;
         case PROP_SORT_TYPE:
             settings->priv->sort_type = g_value_get_uint ( value );
             break;
         case PROP_THUMBNAIL_SIZE:
             settings->priv->thumbnail_size = g_value_get_uint (value);
             break;
+        case PROP_USE_INTERNAL_THUMBNAILER:
+            settings->priv->use_internal_thumbnailer = g_value_get_boolean (value);
+            break;
+        case PROP_THUMBNAIL_PREFETCH:
+            settings->priv->thumbnail_prefetch = g_value_get_uint (value);
+            break;
         default:
             break;
     }
@@ -850,11 +872,6 @@ rstto_settings_get_property    (GObject    *object,
         case PROP_MAXIMIZE_ON_STARTUP:
             g_value_set_boolean (value, settings->priv->maximize_on_startup);
             break;
-        case PROP_ERROR_MISSING_THUMBNAILER:
-            g_value_set_boolean (
-                    value,
-                    settings->priv->errors.missing_thumbnailer);
-            break;
         case PROP_SORT_TYPE:
             g_value_set_uint (
                     value,
@@ -865,6 +882,16 @@ rstto_settings_get_property    (GObject    *object,
                     value,
                     settings->priv->thumbnail_size);
             break;
+        case PROP_USE_INTERNAL_THUMBNAILER:
+            g_value_set_boolean (
+                    value,
+                    settings->priv->use_internal_thumbnailer);
+            break;
+        case PROP_THUMBNAIL_PREFETCH:
+            g_value_set_uint (
+                    value,
+                    settings->priv->thumbnail_prefetch);
+            break;
         default:
             break;
 
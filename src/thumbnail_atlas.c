@@ -0,0 +1,291 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  An atlas of the thumbnails drawn by the icon-bar. The thumbnails are
+ *  converted once and packed into a few large surfaces, in the format of
+ *  the window they are drawn on. Drawing an item is a blit from one of
+ *  those surfaces.
+ *
+ *  Every slot has room for the largest thumbnail of the current size,
+ *  when the atlas is full the least recently used slot is reused.
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+
+#include "thumbnail_atlas.h"
+
+/* Width and height of a page, in pixels */
+#define RSTTO_THUMBNAIL_ATLAS_PAGE_SIZE 1024
+
+/* Pages are added as they are needed, up to this many pixels */
+#define RSTTO_THUMBNAIL_ATLAS_MAX_PIXELS (4 * 1024 * 1024)
+
+typedef struct _RsttoThumbnailAtlasSlot RsttoThumbnailAtlasSlot;
+
+struct _RsttoThumbnailAtlasSlot
+{
+    RsttoThumbnailAtlas *atlas;
+
+    /* Not referenced, NULL if the slot is free */
+    GdkPixbuf           *pixbuf;
+
+    cairo_surface_t     *page;
+    gint                 x;
+    gint                 y;
+
+    /* Link in the LRU-queue, the data is the slot */
+    GList                link;
+};
+
+struct _RsttoThumbnailAtlas
+{
+    gint        slot_size;
+    gint        slots_per_row;
+    guint       max_pages;
+
+    /* cairo_surface_t */
+    GPtrArray  *pages;
+
+    /* RsttoThumbnailAtlasSlot arrays, one per page */
+    GPtrArray  *slots;
+
+    /* GdkPixbuf -> RsttoThumbnailAtlasSlot */
+    GHashTable *pixbufs;
+
+    /* Most recently used first, free slots last */
+    GQueue      lru;
+};
+
+static void
+cb_rstto_thumbnail_atlas_pixbuf_finalized (
+        gpointer data,
+        GObject *pixbuf);
+
+/**
+ * rstto_thumbnail_atlas_new:
+ * @slot_size: Size of a slot, the width and height of the largest thumbnail
+ *
+ * The pages are created when they are needed, from the cairo-context
+ * passed to rstto_thumbnail_atlas_lookup.
+ *
+ * Return value: A new atlas, free it with rstto_thumbnail_atlas_free
+ */
+RsttoThumbnailAtlas *
+rstto_thumbnail_atlas_new (
+        gint slot_size)
+{
+    RsttoThumbnailAtlas *atlas;
+    gint page_size;
+
+    g_return_val_if_fail (slot_size > 0, NULL);
+
+    atlas = g_new0 (RsttoThumbnailAtlas, 1);
+
+    atlas->slot_size = slot_size;
+    atlas->slots_per_row = MAX (1, RSTTO_THUMBNAIL_ATLAS_PAGE_SIZE / slot_size);
+
+    page_size = atlas->slots_per_row * slot_size;
+    atlas->max_pages = MAX (1, RSTTO_THUMBNAIL_ATLAS_MAX_PIXELS / (page_size * page_size));
+
+    atlas->pages = g_ptr_array_new ();
+    atlas->slots = g_ptr_array_new ();
+    atlas->pixbufs = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_queue_init (&atlas->lru);
+
+    return atlas;
+}
+
+void
+rstto_thumbnail_atlas_free (
+        RsttoThumbnailAtlas *atlas)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    guint i;
+
+    g_hash_table_iter_init (&iter, atlas->pixbufs);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        g_object_weak_unref (
+                G_OBJECT (key),
+                cb_rstto_thumbnail_atlas_pixbuf_finalized,
+                value);
+    }
+    g_hash_table_destroy (atlas->pixbufs);
+
+    for (i = 0; i < atlas->pages->len; ++i)
+    {
+        cairo_surface_destroy (g_ptr_array_index (atlas->pages, i));
+        g_free (g_ptr_array_index (atlas->slots, i));
+    }
+    g_ptr_array_free (atlas->pages, TRUE);
+    g_ptr_array_free (atlas->slots, TRUE);
+
+    g_free (atlas);
+}
+
+/**
+ * rstto_thumbnail_atlas_release_slot:
+ * @slot:
+ *
+ * Forget the pixbuf in @slot, the slot is reused first.
+ */
+static void
+rstto_thumbnail_atlas_release_slot (
+        RsttoThumbnailAtlasSlot *slot)
+{
+    RsttoThumbnailAtlas *atlas = slot->atlas;
+
+    g_hash_table_remove (atlas->pixbufs, slot->pixbuf);
+    slot->pixbuf = NULL;
+
+    g_queue_unlink (&atlas->lru, &slot->link);
+    g_queue_push_tail_link (&atlas->lru, &slot->link);
+}
+
+static void
+cb_rstto_thumbnail_atlas_pixbuf_finalized (
+        gpointer data,
+        GObject *pixbuf)
+{
+    rstto_thumbnail_atlas_release_slot (data);
+}
+
+/**
+ * rstto_thumbnail_atlas_add_page:
+ * @atlas:
+ * @cr: The surface of the page is similar to the target of @cr
+ *
+ * The slots of the new page are free, they are added to the end of the
+ * LRU-queue.
+ */
+static void
+rstto_thumbnail_atlas_add_page (
+        RsttoThumbnailAtlas *atlas,
+        cairo_t *cr)
+{
+    RsttoThumbnailAtlasSlot *slots;
+    cairo_surface_t *page;
+    gint n_slots = atlas->slots_per_row * atlas->slots_per_row;
+    gint i;
+
+    page = cairo_surface_create_similar (
+            cairo_get_target (cr),
+            CAIRO_CONTENT_COLOR_ALPHA,
+            atlas->slots_per_row * atlas->slot_size,
+            atlas->slots_per_row * atlas->slot_size);
+
+    slots = g_new0 (RsttoThumbnailAtlasSlot, n_slots);
+    for (i = 0; i < n_slots; ++i)
+    {
+        slots[i].atlas = atlas;
+        slots[i].page = page;
+        slots[i].x = (i % atlas->slots_per_row) * atlas->slot_size;
+        slots[i].y = (i / atlas->slots_per_row) * atlas->slot_size;
+        slots[i].link.data = &slots[i];
+        g_queue_push_tail_link (&atlas->lru, &slots[i].link);
+    }
+
+    g_ptr_array_add (atlas->pages, page);
+    g_ptr_array_add (atlas->slots, slots);
+}
+
+/**
+ * rstto_thumbnail_atlas_lookup:
+ * @atlas:
+ * @cr: Context of the window the thumbnail is drawn on
+ * @pixbuf: The thumbnail
+ * @x: Return location for the position of @pixbuf in the page
+ * @y:
+ *
+ * Look up @pixbuf in the atlas, it is added if it is not in there yet.
+ * The slot is kept until @pixbuf is finalized or the slot is reused.
+ *
+ * Return value: The page that holds @pixbuf, owned by @atlas. NULL if
+ *               @pixbuf does not fit in a slot.
+ */
+cairo_surface_t *
+rstto_thumbnail_atlas_lookup (
+        RsttoThumbnailAtlas *atlas,
+        cairo_t *cr,
+        GdkPixbuf *pixbuf,
+        gint *x,
+        gint *y)
+{
+    RsttoThumbnailAtlasSlot *slot;
+    cairo_t *page_cr;
+
+    slot = g_hash_table_lookup (atlas->pixbufs, pixbuf);
+    if (NULL == slot)
+    {
+        if ( (gdk_pixbuf_get_width (pixbuf) > atlas->slot_size) ||
+             (gdk_pixbuf_get_height (pixbuf) > atlas->slot_size) )
+        {
+            return NULL;
+        }
+
+        /* Add a page before the slots in use are reused */
+        slot = g_queue_peek_tail (&atlas->lru);
+        if ( ( (NULL == slot) || (NULL != slot->pixbuf) ) &&
+             (atlas->pages->len < atlas->max_pages) )
+        {
+            rstto_thumbnail_atlas_add_page (atlas, cr);
+            slot = g_queue_peek_tail (&atlas->lru);
+        }
+
+        if (NULL != slot->pixbuf)
+        {
+            g_object_weak_unref (
+                    G_OBJECT (slot->pixbuf),
+                    cb_rstto_thumbnail_atlas_pixbuf_finalized,
+                    slot);
+            rstto_thumbnail_atlas_release_slot (slot);
+        }
+
+        page_cr = cairo_create (slot->page);
+        cairo_set_operator (page_cr, CAIRO_OPERATOR_SOURCE);
+        gdk_cairo_set_source_pixbuf (page_cr, pixbuf, slot->x, slot->y);
+        cairo_rectangle (
+                page_cr,
+                slot->x,
+                slot->y,
+                gdk_pixbuf_get_width (pixbuf),
+                gdk_pixbuf_get_height (pixbuf));
+        cairo_fill (page_cr);
+        cairo_destroy (page_cr);
+
+        slot->pixbuf = pixbuf;
+        g_hash_table_insert (atlas->pixbufs, pixbuf, slot);
+        g_object_weak_ref (
+                G_OBJECT (pixbuf),
+                cb_rstto_thumbnail_atlas_pixbuf_finalized,
+                slot);
+    }
+
+    g_queue_unlink (&atlas->lru, &slot->link);
+    g_queue_push_head_link (&atlas->lru, &slot->link);
+
+    *x = slot->x;
+    *y = slot->y;
+
+    return slot->page;
+}
@@ -0,0 +1,322 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  The thumbnails of all files share a single cache with a fixed budget,
+ *  the least recently drawn thumbnails are dropped first. Thumbnails of
+ *  other sizes than the one that is shown are dropped first, and all of
+ *  them when loading is done.
+ *
+ *  The cache is only used from the main-thread.
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <libexif/exif-data.h>
+
+#include "util.h"
+#include "file.h"
+#include "thumbnail_cache.h"
+
+/* 64 MiB, some 4000 thumbnails of the normal size */
+#define RSTTO_THUMBNAIL_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+typedef struct _RsttoThumbnailCacheEntry RsttoThumbnailCacheEntry;
+
+struct _RsttoThumbnailCacheEntry
+{
+    /* Not referenced, the entries of a file are removed when it is
+     * disposed. See rstto_thumbnail_cache_remove.
+     */
+    RsttoFile          *r_file;
+    RsttoThumbnailSize  size;
+
+    GdkPixbuf          *pixbuf;
+    gsize               n_bytes;
+
+    /* Link in the lru-queue */
+    GList              *link;
+};
+
+/* (file, size) -> RsttoThumbnailCacheEntry */
+static GHashTable *cache_entries = NULL;
+
+/* Most recently used first */
+static GQueue cache_lru = G_QUEUE_INIT;
+
+static gsize cache_n_bytes = 0;
+
+static RsttoThumbnailSize cache_size = THUMBNAIL_SIZE_NORMAL;
+
+static guint
+rstto_thumbnail_cache_entry_hash (gconstpointer key)
+{
+    const RsttoThumbnailCacheEntry *entry = key;
+
+    return g_direct_hash (entry->r_file) ^ entry->size;
+}
+
+static gboolean
+rstto_thumbnail_cache_entry_equal (
+        gconstpointer a,
+        gconstpointer b)
+{
+    const RsttoThumbnailCacheEntry *entry_a = a;
+    const RsttoThumbnailCacheEntry *entry_b = b;
+
+    return (entry_a->r_file == entry_b->r_file) &&
+           (entry_a->size == entry_b->size);
+}
+
+static RsttoThumbnailCacheEntry *
+rstto_thumbnail_cache_get_entry (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size)
+{
+    RsttoThumbnailCacheEntry key;
+
+    if (NULL == cache_entries)
+    {
+        return NULL;
+    }
+
+    key.r_file = r_file;
+    key.size = size;
+
+    return g_hash_table_lookup (cache_entries, &key);
+}
+
+static void
+rstto_thumbnail_cache_remove_entry (
+        RsttoThumbnailCacheEntry *entry)
+{
+    g_hash_table_remove (cache_entries, entry);
+    g_queue_delete_link (&cache_lru, entry->link);
+    cache_n_bytes -= entry->n_bytes;
+
+    g_object_unref (entry->pixbuf);
+    g_slice_free (RsttoThumbnailCacheEntry, entry);
+}
+
+/**
+ * rstto_thumbnail_cache_lookup:
+ * @r_file:
+ * @size:
+ *
+ * Lookup a thumbnail that is about to be drawn, if it has the size
+ * that is shown it is moved to the front of the cache.
+ *
+ * Return value: the thumbnail, or NULL if it is not in the cache.
+ */
+const GdkPixbuf *
+rstto_thumbnail_cache_lookup (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size)
+{
+    RsttoThumbnailCacheEntry *entry;
+
+    entry = rstto_thumbnail_cache_get_entry (r_file, size);
+    if (NULL == entry)
+    {
+        return NULL;
+    }
+
+    /* Other sizes stay at the end, see rstto_thumbnail_cache_purge */
+    if (entry->size == cache_size)
+    {
+        g_queue_unlink (&cache_lru, entry->link);
+        g_queue_push_head_link (&cache_lru, entry->link);
+    }
+
+    return entry->pixbuf;
+}
+
+/**
+ * rstto_thumbnail_cache_peek:
+ * @r_file:
+ * @size:
+ *
+ * Like rstto_thumbnail_cache_lookup, but the position in the cache
+ * is not changed.
+ */
+const GdkPixbuf *
+rstto_thumbnail_cache_peek (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size)
+{
+    RsttoThumbnailCacheEntry *entry;
+
+    entry = rstto_thumbnail_cache_get_entry (r_file, size);
+    if (NULL == entry)
+    {
+        return NULL;
+    }
+
+    return entry->pixbuf;
+}
+
+/**
+ * rstto_thumbnail_cache_insert:
+ * @r_file:
+ * @size:
+ * @pixbuf: the thumbnail, or NULL to remove it
+ *
+ * The least recently used thumbnails are dropped to stay within the
+ * budget, the new thumbnail itself is always kept.
+ */
+void
+rstto_thumbnail_cache_insert (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size,
+        GdkPixbuf *pixbuf)
+{
+    RsttoThumbnailCacheEntry *entry;
+
+    if (NULL == cache_entries)
+    {
+        cache_entries = g_hash_table_new (
+                rstto_thumbnail_cache_entry_hash,
+                rstto_thumbnail_cache_entry_equal);
+    }
+
+    entry = rstto_thumbnail_cache_get_entry (r_file, size);
+    if (NULL != entry)
+    {
+        rstto_thumbnail_cache_remove_entry (entry);
+    }
+
+    if (NULL == pixbuf)
+    {
+        return;
+    }
+
+    entry = g_slice_new0 (RsttoThumbnailCacheEntry);
+    entry->r_file = r_file;
+    entry->size = size;
+    entry->pixbuf = g_object_ref (pixbuf);
+    entry->n_bytes = sizeof (RsttoThumbnailCacheEntry) +
+            gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+
+    while ( (cache_n_bytes + entry->n_bytes > RSTTO_THUMBNAIL_CACHE_MAX_SIZE) &&
+            (NULL != cache_lru.tail) )
+    {
+        rstto_thumbnail_cache_remove_entry (cache_lru.tail->data);
+    }
+
+    /* Thumbnails of another size are only kept as a placeholder
+     * until the current size is loaded, they go first.
+     */
+    if (size == cache_size)
+    {
+        g_queue_push_head (&cache_lru, entry);
+        entry->link = cache_lru.head;
+    }
+    else
+    {
+        g_queue_push_tail (&cache_lru, entry);
+        entry->link = cache_lru.tail;
+    }
+
+    g_hash_table_insert (cache_entries, entry, entry);
+    cache_n_bytes += entry->n_bytes;
+}
+
+/**
+ * rstto_thumbnail_cache_set_size:
+ * @size: The thumbnail-size that is shown
+ *
+ * The thumbnails of the previous size are moved to the end of the
+ * cache, they are dropped by the next rstto_thumbnail_cache_purge.
+ */
+void
+rstto_thumbnail_cache_set_size (
+        RsttoThumbnailSize size)
+{
+    RsttoThumbnailCacheEntry *entry;
+    GList *iter;
+    GList *next;
+    GQueue demoted = G_QUEUE_INIT;
+
+    cache_size = size;
+
+    for (iter = cache_lru.head; iter != NULL; iter = next)
+    {
+        next = g_list_next (iter);
+        entry = iter->data;
+
+        if (entry->size != size)
+        {
+            g_queue_unlink (&cache_lru, iter);
+            g_queue_push_tail_link (&demoted, iter);
+        }
+    }
+
+    /* Append the demoted links, in the same order */
+    while (NULL != (iter = g_queue_pop_head_link (&demoted)))
+    {
+        g_queue_push_tail_link (&cache_lru, iter);
+    }
+}
+
+/**
+ * rstto_thumbnail_cache_purge:
+ *
+ * Drop the thumbnails of all sizes but the one that is shown.
+ */
+void
+rstto_thumbnail_cache_purge (void)
+{
+    RsttoThumbnailCacheEntry *entry;
+
+    while (NULL != cache_lru.tail)
+    {
+        entry = cache_lru.tail->data;
+        if (entry->size == cache_size)
+        {
+            break;
+        }
+        rstto_thumbnail_cache_remove_entry (entry);
+    }
+}
+
+/**
+ * rstto_thumbnail_cache_remove:
+ * @r_file:
+ *
+ * Drop the thumbnails of @r_file, of all sizes. Called when @r_file
+ * is disposed, the cache does not keep files alive.
+ */
+void
+rstto_thumbnail_cache_remove (
+        RsttoFile *r_file)
+{
+    RsttoThumbnailCacheEntry *entry;
+    gint size;
+
+    for (size = 0; size < THUMBNAIL_SIZE_COUNT; ++size)
+    {
+        entry = rstto_thumbnail_cache_get_entry (r_file, size);
+        if (NULL != entry)
+        {
+            rstto_thumbnail_cache_remove_entry (entry);
+        }
+    }
+}
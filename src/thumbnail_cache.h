@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_THUMBNAIL_CACHE_H__
+#define __RISTRETTO_THUMBNAIL_CACHE_H__
+
+G_BEGIN_DECLS
+
+const GdkPixbuf *
+rstto_thumbnail_cache_lookup (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size);
+
+const GdkPixbuf *
+rstto_thumbnail_cache_peek (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size);
+
+void
+rstto_thumbnail_cache_insert (
+        RsttoFile *r_file,
+        RsttoThumbnailSize size,
+        GdkPixbuf *pixbuf);
+
+void
+rstto_thumbnail_cache_remove (
+        RsttoFile *r_file);
+
+void
+rstto_thumbnail_cache_set_size (
+        RsttoThumbnailSize size);
+
+void
+rstto_thumbnail_cache_purge (void);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_THUMBNAIL_CACHE_H__ */
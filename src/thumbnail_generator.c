@@ -0,0 +1,450 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  Generates thumbnails in the freedesktop.org thumbnail-cache when no
+ *  thumbnailing-service is available, see:
+ *  http://specifications.freedesktop.org/thumbnail-spec/
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <libexif/exif-data.h>
+
+#include "util.h"
+#include "file.h"
+#include "thumbnail_generator.h"
+
+/* Decoding is CPU-bound, leave some room for the image-viewer */
+#define RSTTO_THUMBNAIL_GENERATOR_MAX_THREADS 2
+
+#define RSTTO_THUMBNAIL_GENERATOR_BUFFER_SIZE 65536
+
+typedef struct _RsttoThumbnailGeneratorRequest RsttoThumbnailGeneratorRequest;
+
+struct _RsttoThumbnailGeneratorRequest
+{
+    RsttoFile            *r_file;
+    RsttoThumbnailFlavor  flavor;
+    gint                  serial;
+
+    /* Set by rstto_thumbnail_generator_dequeue_file */
+    volatile gint         cancelled;
+
+    /* Copied, the worker-thread does not touch the RsttoFile */
+    gchar                *uri;
+    gchar                *path;
+
+    RsttoThumbnailGeneratorFunc func;
+    gpointer              user_data;
+
+    gboolean              success;
+};
+
+static GThreadPool *generator_pool = NULL;
+
+/* RsttoFile -> RsttoThumbnailGeneratorRequest per flavor, main-thread only */
+static GHashTable *generator_requests[THUMBNAIL_FLAVOR_COUNT];
+
+static gint generator_serial = 0;
+
+static void
+rstto_thumbnail_generator_thread (
+        gpointer data,
+        gpointer user_data);
+
+static gboolean
+cb_rstto_thumbnail_generator_request_done (
+        gpointer user_data);
+
+static gint
+rstto_thumbnail_generator_compare_requests (
+        gconstpointer a,
+        gconstpointer b,
+        gpointer user_data)
+{
+    const RsttoThumbnailGeneratorRequest *request_a = a;
+    const RsttoThumbnailGeneratorRequest *request_b = b;
+
+    /* Most recent first, those are for the visible items */
+    return request_b->serial - request_a->serial;
+}
+
+/**
+ * rstto_thumbnail_generator_queue_file:
+ * @r_file:
+ * @flavor:
+ * @func: called when the thumbnail is done
+ * @user_data:
+ *
+ * Return value: FALSE if @r_file is already queued for @flavor, @func
+ *               will not be called for this request.
+ */
+gboolean
+rstto_thumbnail_generator_queue_file (
+        RsttoFile *r_file,
+        RsttoThumbnailFlavor flavor,
+        RsttoThumbnailGeneratorFunc func,
+        gpointer user_data)
+{
+    RsttoThumbnailGeneratorRequest *request;
+    gint i;
+
+    g_return_val_if_fail (RSTTO_IS_FILE (r_file), FALSE);
+
+    if (NULL == generator_pool)
+    {
+        for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+        {
+            generator_requests[i] = g_hash_table_new (g_direct_hash, g_direct_equal);
+        }
+        generator_pool = g_thread_pool_new (
+                rstto_thumbnail_generator_thread,
+                NULL,
+                RSTTO_THUMBNAIL_GENERATOR_MAX_THREADS,
+                FALSE,
+                NULL);
+        g_thread_pool_set_sort_function (
+                generator_pool,
+                rstto_thumbnail_generator_compare_requests,
+                NULL);
+    }
+
+    request = g_hash_table_lookup (generator_requests[flavor], r_file);
+    if (NULL != request)
+    {
+        /* Queued again after it was dequeued */
+        g_atomic_int_set (&request->cancelled, 0);
+        return FALSE;
+    }
+
+    request = g_new0 (RsttoThumbnailGeneratorRequest, 1);
+    request->r_file = g_object_ref (r_file);
+    request->flavor = flavor;
+    request->serial = ++generator_serial;
+    request->uri = g_strdup (rstto_file_get_uri (r_file));
+    request->path = g_strdup (rstto_file_get_path (r_file));
+    request->func = func;
+    request->user_data = user_data;
+
+    g_hash_table_insert (generator_requests[flavor], r_file, request);
+
+    g_thread_pool_push (generator_pool, request, NULL);
+
+    return TRUE;
+}
+
+/**
+ * rstto_thumbnail_generator_dequeue_file:
+ * @r_file:
+ *
+ * The thumbnails of @r_file are not generated if that did not start yet.
+ */
+void
+rstto_thumbnail_generator_dequeue_file (
+        RsttoFile *r_file)
+{
+    RsttoThumbnailGeneratorRequest *request;
+    gint i;
+
+    if (NULL == generator_pool)
+    {
+        return;
+    }
+
+    for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+    {
+        request = g_hash_table_lookup (generator_requests[i], r_file);
+        if (NULL != request)
+        {
+            g_atomic_int_set (&request->cancelled, 1);
+        }
+    }
+}
+
+static void
+cb_rstto_thumbnail_generator_size_prepared (
+        GdkPixbufLoader *loader,
+        gint width,
+        gint height,
+        gpointer user_data)
+{
+    gint size = GPOINTER_TO_INT (user_data);
+
+    /* Thumbnails are never larger than the image */
+    if ( (width > size) || (height > size) )
+    {
+        if (width > height)
+        {
+            height = MAX (1, height * size / width);
+            width = size;
+        }
+        else
+        {
+            width = MAX (1, width * size / height);
+            height = size;
+        }
+
+        /* The JPEG-loader decodes at a reduced scale when the
+         * size is set here, instead of scaling the full image.
+         */
+        gdk_pixbuf_loader_set_size (loader, width, height);
+    }
+}
+
+static GdkPixbuf *
+rstto_thumbnail_generator_load (
+        const gchar *path,
+        gint size)
+{
+    GdkPixbufLoader *loader;
+    GdkPixbuf *pixbuf = NULL;
+    guchar *buffer;
+    gsize length;
+    gboolean ret_val = TRUE;
+    FILE *fp;
+
+    fp = g_fopen (path, "rb");
+    if (NULL == fp)
+    {
+        return NULL;
+    }
+
+    loader = gdk_pixbuf_loader_new ();
+    g_signal_connect (
+            loader,
+            "size-prepared",
+            G_CALLBACK (cb_rstto_thumbnail_generator_size_prepared),
+            GINT_TO_POINTER (size));
+
+    buffer = g_malloc (RSTTO_THUMBNAIL_GENERATOR_BUFFER_SIZE);
+    while ( (TRUE == ret_val) &&
+            (length = fread (buffer, 1, RSTTO_THUMBNAIL_GENERATOR_BUFFER_SIZE, fp)) > 0 )
+    {
+        ret_val = gdk_pixbuf_loader_write (loader, buffer, length, NULL);
+    }
+    g_free (buffer);
+    fclose (fp);
+
+    if ( (TRUE == gdk_pixbuf_loader_close (loader, NULL)) &&
+         (TRUE == ret_val) )
+    {
+        pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+        if (NULL != pixbuf)
+        {
+            g_object_ref (pixbuf);
+        }
+    }
+
+    g_object_unref (loader);
+
+    return pixbuf;
+}
+
+/**
+ * rstto_thumbnail_generator_save:
+ *
+ * Write the thumbnail to a temporary file in the same directory and
+ * move it in place, other readers never see a partial thumbnail.
+ */
+static gboolean
+rstto_thumbnail_generator_save (
+        GdkPixbuf *pixbuf,
+        const gchar *thumbnail_path,
+        const gchar *uri,
+        const gchar *mtime,
+        const gchar *size)
+{
+    gchar *tmp_path;
+    gchar *buffer = NULL;
+    gsize length = 0;
+    gsize written = 0;
+    gssize n;
+    gboolean ret_val = FALSE;
+    gint fd;
+
+    if (FALSE == gdk_pixbuf_save_to_buffer (
+            pixbuf,
+            &buffer,
+            &length,
+            "png",
+            NULL,
+            "tEXt::Thumb::URI", uri,
+            "tEXt::Thumb::MTime", mtime,
+            "tEXt::Thumb::Size", size,
+            "tEXt::Software", "Ristretto",
+            NULL))
+    {
+        return FALSE;
+    }
+
+    /* Created with mode 0600, as required by the specification */
+    tmp_path = g_strconcat (thumbnail_path, ".XXXXXX", NULL);
+    fd = g_mkstemp (tmp_path);
+    if (fd >= 0)
+    {
+        while (written < length)
+        {
+            n = write (fd, buffer + written, length - written);
+            if (n <= 0)
+            {
+                break;
+            }
+            written += n;
+        }
+
+        if ( (0 == close (fd)) && (written == length) &&
+             (0 == g_rename (tmp_path, thumbnail_path)) )
+        {
+            ret_val = TRUE;
+        }
+        else
+        {
+            g_unlink (tmp_path);
+        }
+    }
+
+    g_free (tmp_path);
+    g_free (buffer);
+
+    return ret_val;
+}
+
+static gboolean
+rstto_thumbnail_generator_generate (
+        RsttoThumbnailGeneratorRequest *request)
+{
+    GdkPixbuf *pixbuf;
+    struct stat st;
+    gchar *checksum;
+    gchar *filename;
+    gchar *dir;
+    gchar *thumbnail_path;
+    gchar *mtime;
+    gchar *size;
+    gboolean ret_val = FALSE;
+
+    if ( (NULL == request->path) ||
+         (0 != g_stat (request->path, &st)) )
+    {
+        return FALSE;
+    }
+
+    mtime = g_strdup_printf ("%" G_GUINT64_FORMAT, (guint64) st.st_mtime);
+    size = g_strdup_printf ("%" G_GUINT64_FORMAT, (guint64) st.st_size);
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, request->uri, -1);
+    filename = g_strconcat (checksum, ".png", NULL);
+    dir = g_build_filename (
+            g_get_user_cache_dir (),
+            "thumbnails",
+            (request->flavor == THUMBNAIL_FLAVOR_LARGE) ? "large" : "normal",
+            NULL);
+    thumbnail_path = g_build_filename (dir, filename, NULL);
+
+    /* Another thumbnailer may have been faster */
+    pixbuf = gdk_pixbuf_new_from_file (thumbnail_path, NULL);
+    if (NULL != pixbuf)
+    {
+        ret_val = (0 == g_strcmp0 (
+                gdk_pixbuf_get_option (pixbuf, "tEXt::Thumb::MTime"),
+                mtime));
+        g_object_unref (pixbuf);
+    }
+
+    if ( (FALSE == ret_val) &&
+         (0 == g_atomic_int_get (&request->cancelled)) )
+    {
+        pixbuf = rstto_thumbnail_generator_load (
+                request->path,
+                (request->flavor == THUMBNAIL_FLAVOR_LARGE) ?
+                        THUMBNAIL_FLAVOR_LARGE_SIZE :
+                        THUMBNAIL_FLAVOR_NORMAL_SIZE);
+        if (NULL != pixbuf)
+        {
+            if (0 == g_mkdir_with_parents (dir, 0700))
+            {
+                ret_val = rstto_thumbnail_generator_save (
+                        pixbuf,
+                        thumbnail_path,
+                        request->uri,
+                        mtime,
+                        size);
+            }
+            g_object_unref (pixbuf);
+        }
+    }
+
+    g_free (thumbnail_path);
+    g_free (dir);
+    g_free (filename);
+    g_free (checksum);
+    g_free (size);
+    g_free (mtime);
+
+    return ret_val;
+}
+
+static void
+rstto_thumbnail_generator_thread (
+        gpointer data,
+        gpointer user_data)
+{
+    RsttoThumbnailGeneratorRequest *request = data;
+
+    if (0 == g_atomic_int_get (&request->cancelled))
+    {
+        request->success = rstto_thumbnail_generator_generate (request);
+    }
+
+    gdk_threads_add_idle (
+            cb_rstto_thumbnail_generator_request_done,
+            request);
+}
+
+static gboolean
+cb_rstto_thumbnail_generator_request_done (
+        gpointer user_data)
+{
+    RsttoThumbnailGeneratorRequest *request = user_data;
+
+    g_hash_table_remove (generator_requests[request->flavor], request->r_file);
+
+    request->func (
+            request->r_file,
+            request->flavor,
+            request->success,
+            request->user_data);
+
+    g_object_unref (request->r_file);
+    g_free (request->uri);
+    g_free (request->path);
+    g_free (request);
+
+    return FALSE;
+}
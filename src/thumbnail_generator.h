@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_THUMBNAIL_GENERATOR_H__
+#define __RISTRETTO_THUMBNAIL_GENERATOR_H__
+
+G_BEGIN_DECLS
+
+/**
+ * RsttoThumbnailGeneratorFunc:
+ * @r_file:
+ * @flavor:
+ * @success: TRUE if an up-to-date thumbnail is in the thumbnail-cache
+ * @user_data:
+ *
+ * Called from the main-loop exactly once for every file that was queued
+ * by rstto_thumbnail_generator_queue_file, also if it was dequeued.
+ */
+typedef void (*RsttoThumbnailGeneratorFunc) (
+        RsttoFile *r_file,
+        RsttoThumbnailFlavor flavor,
+        gboolean success,
+        gpointer user_data);
+
+gboolean
+rstto_thumbnail_generator_queue_file (
+        RsttoFile *r_file,
+        RsttoThumbnailFlavor flavor,
+        RsttoThumbnailGeneratorFunc func,
+        gpointer user_data);
+
+void
+rstto_thumbnail_generator_dequeue_file (
+        RsttoFile *r_file);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_THUMBNAIL_GENERATOR_H__ */
@@ -0,0 +1,466 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ *
+ *  An index of the files in the thumbnail-directories, so the thumbnail
+ *  of a file is found with a lookup instead of a stat per directory.
+ *  The directories are read once on a worker-thread and kept up to date
+ *  with a file-monitor, a file that is not in the index has no thumbnail
+ *  until the thumbnailer reports otherwise. Until the directories have
+ *  been read, lookups are answered as unknown.
+ *
+ *  The index is only used from the main-thread.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include "util.h"
+#include "thumbnail_index.h"
+
+typedef enum
+{
+    RSTTO_THUMBNAIL_INDEX_DIR_CACHE = 0, /* $XDG_CACHE_HOME/thumbnails */
+    RSTTO_THUMBNAIL_INDEX_DIR_LEGACY,    /* ~/.thumbnails */
+    RSTTO_THUMBNAIL_INDEX_DIR_COUNT
+} RsttoThumbnailIndexDir;
+
+typedef struct _RsttoThumbnailIndex RsttoThumbnailIndex;
+
+struct _RsttoThumbnailIndex
+{
+    gchar        *dirs[RSTTO_THUMBNAIL_INDEX_DIR_COUNT];
+    GFileMonitor *monitors[RSTTO_THUMBNAIL_INDEX_DIR_COUNT];
+
+    /* Filename -> mask of the directories it is in */
+    GHashTable   *names;
+
+    /* FALSE while the directories are being read */
+    gboolean      ready;
+};
+
+typedef struct _RsttoThumbnailIndexScan RsttoThumbnailIndexScan;
+
+struct _RsttoThumbnailIndexScan
+{
+    RsttoThumbnailIndex *index;
+
+    /* Result, filename -> mask like RsttoThumbnailIndex.names */
+    GHashTable          *names;
+};
+
+static RsttoThumbnailIndex *thumbnail_index[THUMBNAIL_FLAVOR_COUNT];
+
+/* Reads the thumbnail-directories, off the UI thread */
+static GThreadPool *scan_pool = NULL;
+
+static void
+cb_rstto_thumbnail_index_changed (
+        GFileMonitor      *monitor,
+        GFile             *file,
+        GFile             *other_file,
+        GFileMonitorEvent  event_type,
+        gpointer           user_data);
+
+static void
+cb_rstto_thumbnail_index_scan (
+        gpointer data,
+        gpointer user_data);
+
+static gboolean
+cb_rstto_thumbnail_index_scan_done (
+        gpointer user_data);
+
+static gchar *
+rstto_thumbnail_index_get_dir (
+        RsttoThumbnailIndexDir dir,
+        RsttoThumbnailFlavor flavor)
+{
+    const gchar *flavor_name;
+
+    flavor_name = (flavor == THUMBNAIL_FLAVOR_LARGE) ? "large" : "normal";
+
+    if (dir == RSTTO_THUMBNAIL_INDEX_DIR_CACHE)
+    {
+        return g_build_filename (
+                g_get_user_cache_dir (),
+                "thumbnails",
+                flavor_name,
+                NULL);
+    }
+
+    return g_build_filename (
+            g_get_home_dir (),
+            ".thumbnails",
+            flavor_name,
+            NULL);
+}
+
+static gchar *
+rstto_thumbnail_index_get_filename (const gchar *uri)
+{
+    gchar *checksum;
+    gchar *filename;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+    filename = g_strconcat (checksum, ".png", NULL);
+    g_free (checksum);
+
+    return filename;
+}
+
+static void
+rstto_thumbnail_index_set (
+        RsttoThumbnailIndex *index,
+        const gchar *filename,
+        RsttoThumbnailIndexDir dir,
+        gboolean present)
+{
+    guint mask;
+
+    mask = GPOINTER_TO_UINT (g_hash_table_lookup (index->names, filename));
+    if (TRUE == present)
+    {
+        mask |= (1 << dir);
+    }
+    else
+    {
+        mask &= ~(1 << dir);
+    }
+
+    if (0 == mask)
+    {
+        g_hash_table_remove (index->names, filename);
+    }
+    else
+    {
+        g_hash_table_insert (
+                index->names,
+                g_strdup (filename),
+                GUINT_TO_POINTER (mask));
+    }
+}
+
+/**
+ * rstto_thumbnail_index_get:
+ * @flavor:
+ *
+ * Start reading the thumbnail-directories of @flavor the first time.
+ */
+static RsttoThumbnailIndex *
+rstto_thumbnail_index_get (RsttoThumbnailFlavor flavor)
+{
+    RsttoThumbnailIndex *index = thumbnail_index[flavor];
+    RsttoThumbnailIndexScan *scan;
+    GFile *dir_file;
+    gint i;
+
+    if (NULL != index)
+    {
+        return index;
+    }
+
+    index = g_new0 (RsttoThumbnailIndex, 1);
+    index->names = g_hash_table_new_full (
+            g_str_hash,
+            g_str_equal,
+            g_free,
+            NULL);
+
+    for (i = 0; i < RSTTO_THUMBNAIL_INDEX_DIR_COUNT; ++i)
+    {
+        index->dirs[i] = rstto_thumbnail_index_get_dir (i, flavor);
+
+        /* Monitor first, nothing is missed while reading */
+        dir_file = g_file_new_for_path (index->dirs[i]);
+        index->monitors[i] = g_file_monitor_directory (
+                dir_file,
+                G_FILE_MONITOR_NONE,
+                NULL,
+                NULL);
+        g_object_unref (dir_file);
+
+        if (NULL != index->monitors[i])
+        {
+            g_object_set_data (
+                    G_OBJECT (index->monitors[i]),
+                    "rstto-thumbnail-index-dir",
+                    GINT_TO_POINTER (i));
+            g_signal_connect (
+                    G_OBJECT (index->monitors[i]),
+                    "changed",
+                    G_CALLBACK (cb_rstto_thumbnail_index_changed),
+                    index);
+        }
+    }
+
+    if (NULL == scan_pool)
+    {
+        scan_pool = g_thread_pool_new (
+                cb_rstto_thumbnail_index_scan,
+                NULL,
+                1,
+                FALSE,
+                NULL);
+    }
+
+    /* The index is never freed, the dirs do not change */
+    scan = g_new0 (RsttoThumbnailIndexScan, 1);
+    scan->index = index;
+    g_thread_pool_push (scan_pool, scan, NULL);
+
+    thumbnail_index[flavor] = index;
+
+    return index;
+}
+
+static void
+cb_rstto_thumbnail_index_scan (
+        gpointer data,
+        gpointer user_data)
+{
+    RsttoThumbnailIndexScan *scan = data;
+    RsttoThumbnailIndex *index = scan->index;
+    GHashTable *names;
+    const gchar *name;
+    GDir *dir;
+    guint mask;
+    gint i;
+
+    /* Filled separately, index->names is owned by the main-thread */
+    names = g_hash_table_new_full (
+            g_str_hash,
+            g_str_equal,
+            g_free,
+            NULL);
+
+    for (i = 0; i < RSTTO_THUMBNAIL_INDEX_DIR_COUNT; ++i)
+    {
+        dir = g_dir_open (index->dirs[i], 0, NULL);
+        if (NULL == dir)
+        {
+            continue;
+        }
+
+        while (NULL != (name = g_dir_read_name (dir)))
+        {
+            mask = GPOINTER_TO_UINT (g_hash_table_lookup (names, name));
+            g_hash_table_insert (
+                    names,
+                    g_strdup (name),
+                    GUINT_TO_POINTER (mask | (1 << i)));
+        }
+        g_dir_close (dir);
+    }
+
+    scan->names = names;
+
+    gdk_threads_add_idle (cb_rstto_thumbnail_index_scan_done, scan);
+}
+
+static gboolean
+cb_rstto_thumbnail_index_scan_done (
+        gpointer user_data)
+{
+    RsttoThumbnailIndexScan *scan = user_data;
+    RsttoThumbnailIndex *index = scan->index;
+    GHashTableIter iter;
+    gpointer name;
+    gpointer mask;
+
+    /* Add what the file-monitor reported while reading, usually
+     * nothing, and take over the names that were read.
+     */
+    g_hash_table_iter_init (&iter, index->names);
+    while (g_hash_table_iter_next (&iter, &name, &mask))
+    {
+        g_hash_table_insert (
+                scan->names,
+                g_strdup (name),
+                GUINT_TO_POINTER (GPOINTER_TO_UINT (mask) |
+                        GPOINTER_TO_UINT (g_hash_table_lookup (scan->names, name))));
+    }
+
+    g_hash_table_destroy (index->names);
+    index->names = scan->names;
+    index->ready = TRUE;
+
+    g_free (scan);
+
+    return FALSE;
+}
+
+static void
+cb_rstto_thumbnail_index_changed (
+        GFileMonitor      *monitor,
+        GFile             *file,
+        GFile             *other_file,
+        GFileMonitorEvent  event_type,
+        gpointer           user_data)
+{
+    RsttoThumbnailIndex *index = user_data;
+    RsttoThumbnailIndexDir dir;
+    gchar *name;
+
+    dir = GPOINTER_TO_INT (g_object_get_data (
+            G_OBJECT (monitor),
+            "rstto-thumbnail-index-dir"));
+
+    switch (event_type)
+    {
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_DELETED:
+            name = g_file_get_basename (file);
+            rstto_thumbnail_index_set (
+                    index,
+                    name,
+                    dir,
+                    event_type == G_FILE_MONITOR_EVENT_CREATED);
+            g_free (name);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * rstto_thumbnail_index_get_path:
+ * @uri:
+ * @flavor:
+ * @path: Return location for the path of the thumbnail of @uri,
+ *        NULL if it does not exist.
+ *
+ * Return value: FALSE if the thumbnail-directories are still being
+ *               read, it is unknown whether the thumbnail exists.
+ */
+gboolean
+rstto_thumbnail_index_get_path (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor,
+        gchar **path)
+{
+    RsttoThumbnailIndex *index = rstto_thumbnail_index_get (flavor);
+    gchar *filename;
+    guint mask;
+    gint i;
+
+    *path = NULL;
+
+    if (FALSE == index->ready)
+    {
+        return FALSE;
+    }
+
+    filename = rstto_thumbnail_index_get_filename (uri);
+    mask = GPOINTER_TO_UINT (g_hash_table_lookup (index->names, filename));
+
+    /* The new location goes first */
+    for (i = 0; i < RSTTO_THUMBNAIL_INDEX_DIR_COUNT; ++i)
+    {
+        if (mask & (1 << i))
+        {
+            *path = g_build_filename (index->dirs[i], filename, NULL);
+            break;
+        }
+    }
+
+    g_free (filename);
+
+    return TRUE;
+}
+
+/**
+ * rstto_thumbnail_index_find_path:
+ * @uri:
+ * @flavor:
+ *
+ * Look for the thumbnail of @uri on disk, for the lookups that are
+ * made while the index is being read. Unlike the rest of the index,
+ * this can be called from any thread.
+ *
+ * Return value: path of the thumbnail of @uri, or NULL if it does
+ *               not exist.
+ */
+gchar *
+rstto_thumbnail_index_find_path (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor)
+{
+    gchar *filename;
+    gchar *dir;
+    gchar *path = NULL;
+    gint i;
+
+    filename = rstto_thumbnail_index_get_filename (uri);
+
+    /* The new location goes first */
+    for (i = 0; (NULL == path) && (i < RSTTO_THUMBNAIL_INDEX_DIR_COUNT); ++i)
+    {
+        dir = rstto_thumbnail_index_get_dir (i, flavor);
+        path = g_build_filename (dir, filename, NULL);
+        g_free (dir);
+
+        if (FALSE == g_file_test (path, G_FILE_TEST_EXISTS))
+        {
+            g_free (path);
+            path = NULL;
+        }
+    }
+
+    g_free (filename);
+
+    return path;
+}
+
+/**
+ * rstto_thumbnail_index_update:
+ * @uri:
+ * @flavor:
+ *
+ * Check the thumbnail of @uri on disk, when the thumbnailer reports it
+ * is ready. The file-monitor may not have seen it yet.
+ */
+void
+rstto_thumbnail_index_update (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor)
+{
+    RsttoThumbnailIndex *index = rstto_thumbnail_index_get (flavor);
+    gchar *filename;
+    gchar *path;
+    gint i;
+
+    filename = rstto_thumbnail_index_get_filename (uri);
+
+    for (i = 0; i < RSTTO_THUMBNAIL_INDEX_DIR_COUNT; ++i)
+    {
+        path = g_build_filename (index->dirs[i], filename, NULL);
+        rstto_thumbnail_index_set (
+                index,
+                filename,
+                i,
+                g_file_test (path, G_FILE_TEST_EXISTS));
+        g_free (path);
+    }
+
+    g_free (filename);
+}
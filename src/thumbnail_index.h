@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_THUMBNAIL_INDEX_H__
+#define __RISTRETTO_THUMBNAIL_INDEX_H__
+
+G_BEGIN_DECLS
+
+gboolean
+rstto_thumbnail_index_get_path (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor,
+        gchar **path);
+
+gchar *
+rstto_thumbnail_index_find_path (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor);
+
+void
+rstto_thumbnail_index_update (
+        const gchar *uri,
+        RsttoThumbnailFlavor flavor);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_THUMBNAIL_INDEX_H__ */
@@ -0,0 +1,754 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#include <config.h>
+
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <libexif/exif-data.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "util.h"
+#include "file.h"
+#include "thumbnailer.h"
+#include "thumbnail_loader.h"
+#include "thumbnail_cache.h"
+#include "thumbnail_index.h"
+#include "metadata.h"
+#include "marshal.h"
+
+/* Reading a thumbnail is mostly waiting for the disk, a couple of
+ * threads is enough to keep up with scrolling.
+ */
+#define RSTTO_THUMBNAIL_LOADER_MAX_THREADS 2
+
+/* Requests that fell this far behind were made for items that have
+ * been scrolled out of view since, they are dropped without loading.
+ */
+#define RSTTO_THUMBNAIL_LOADER_MAX_BACKLOG 256
+
+static guint rstto_thumbnail_size[] =
+{
+    THUMBNAIL_SIZE_VERY_SMALL_SIZE,
+    THUMBNAIL_SIZE_SMALLER_SIZE,
+    THUMBNAIL_SIZE_SMALL_SIZE,
+    THUMBNAIL_SIZE_NORMAL_SIZE,
+    THUMBNAIL_SIZE_LARGE_SIZE,
+    THUMBNAIL_SIZE_LARGER_SIZE,
+    THUMBNAIL_SIZE_VERY_LARGE_SIZE
+};
+
+static void
+rstto_thumbnail_loader_init (GObject *);
+static void
+rstto_thumbnail_loader_class_init (GObjectClass *);
+
+static void
+rstto_thumbnail_loader_dispose (GObject *object);
+static void
+rstto_thumbnail_loader_finalize (GObject *object);
+
+static void
+rstto_thumbnail_loader_thread (
+        gpointer data,
+        gpointer user_data);
+static gint
+rstto_thumbnail_loader_compare_requests (
+        gconstpointer a,
+        gconstpointer b,
+        gpointer user_data);
+static gboolean
+cb_rstto_thumbnail_loader_request_done (
+        gpointer user_data);
+
+static GObjectClass *parent_class = NULL;
+
+static RsttoThumbnailLoader *loader_object;
+
+enum
+{
+    RSTTO_THUMBNAIL_LOADER_SIGNAL_READY = 0,
+    RSTTO_THUMBNAIL_LOADER_SIGNAL_COUNT
+};
+
+static gint rstto_thumbnail_loader_signals[RSTTO_THUMBNAIL_LOADER_SIGNAL_COUNT];
+
+typedef struct _RsttoThumbnailRequest RsttoThumbnailRequest;
+
+struct _RsttoThumbnailRequest
+{
+    RsttoThumbnailLoader *loader;
+    RsttoFile            *r_file;
+    RsttoThumbnailSize    size;
+    gint                  serial;
+
+    /* The flavor @size is scaled down from, and the flavor that is
+     * loaded if that one does not exist.
+     */
+    RsttoThumbnailFlavor  flavor;
+    RsttoThumbnailFlavor  path_flavor;
+
+    /* Copied, the worker-thread does not touch the RsttoFile */
+    gchar                *path;
+    guint64               mtime;
+
+    /* Set if the thumbnail-index is still being read, the
+     * worker-thread looks for the thumbnail on disk.
+     */
+    gchar                *uri;
+
+    /* Local path of a JPEG image without a thumbnail, the embedded
+     * EXIF-thumbnail is shown until one is generated.
+     */
+    gchar                *exif_path;
+
+    /* Result, NULL if there is no thumbnail (yet) */
+    GdkPixbuf            *pixbuf;
+
+    /* Result, RSTTO_THUMBNAIL_STATE_QUEUED if there is no thumbnail and
+     * RSTTO_THUMBNAIL_STATE_UNKNOWN if the request was skipped.
+     */
+    RsttoThumbnailState   state;
+};
+
+GType
+rstto_thumbnail_loader_get_type (void)
+{
+    static GType rstto_thumbnail_loader_type = 0;
+
+    if (!rstto_thumbnail_loader_type)
+    {
+        static const GTypeInfo rstto_thumbnail_loader_info = 
+        {
+            sizeof (RsttoThumbnailLoaderClass),
+            (GBaseInitFunc) NULL,
+            (GBaseFinalizeFunc) NULL,
+            (GClassInitFunc) rstto_thumbnail_loader_class_init,
+            (GClassFinalizeFunc) NULL,
+            NULL,
+            sizeof (RsttoThumbnailLoader),
+            0,
+            (GInstanceInitFunc) rstto_thumbnail_loader_init,
+            NULL
+        };
+
+        rstto_thumbnail_loader_type = g_type_register_static (
+                G_TYPE_OBJECT,
+                "RsttoThumbnailLoader",
+                &rstto_thumbnail_loader_info,
+                0);
+    }
+    return rstto_thumbnail_loader_type;
+}
+
+struct _RsttoThumbnailLoaderPriv
+{
+    GThreadPool *pool;
+
+    /* RsttoFile -> mask of the sizes that are being loaded */
+    GHashTable  *pending;
+
+    /* Incremented for every request, read by the workers */
+    gint         serial;
+};
+
+static void
+rstto_thumbnail_loader_init (GObject *object)
+{
+    RsttoThumbnailLoader *loader = RSTTO_THUMBNAIL_LOADER (object);
+
+    loader->priv = g_new0 (RsttoThumbnailLoaderPriv, 1);
+    loader->priv->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+    loader->priv->pool = g_thread_pool_new (
+            rstto_thumbnail_loader_thread,
+            loader,
+            RSTTO_THUMBNAIL_LOADER_MAX_THREADS,
+            FALSE,
+            NULL);
+
+    /* The most recent requests are for the items that are visible
+     * right now, serve those first.
+     */
+    g_thread_pool_set_sort_function (
+            loader->priv->pool,
+            rstto_thumbnail_loader_compare_requests,
+            NULL);
+}
+
+
+static void
+rstto_thumbnail_loader_class_init (GObjectClass *object_class)
+{
+    RsttoThumbnailLoaderClass *loader_class = RSTTO_THUMBNAIL_LOADER_CLASS (
+            object_class);
+
+    parent_class = g_type_class_peek_parent (loader_class);
+
+    object_class->dispose = rstto_thumbnail_loader_dispose;
+    object_class->finalize = rstto_thumbnail_loader_finalize;
+
+    rstto_thumbnail_loader_signals[RSTTO_THUMBNAIL_LOADER_SIGNAL_READY] = g_signal_new("ready",
+            G_TYPE_FROM_CLASS(loader_class),
+            G_SIGNAL_RUN_LAST,
+            0,
+            NULL,
+            NULL,
+            _rstto_marshal_VOID__OBJECT_UINT,
+            G_TYPE_NONE,
+            2,
+            G_TYPE_OBJECT,
+            G_TYPE_UINT,
+            NULL);
+}
+
+/**
+ * rstto_thumbnail_loader_dispose:
+ * @object:
+ *
+ */
+static void
+rstto_thumbnail_loader_dispose (GObject *object)
+{
+    RsttoThumbnailLoader *loader = RSTTO_THUMBNAIL_LOADER (object);
+
+    if (loader->priv)
+    {
+        /* Every request holds a reference, the pool is idle */
+        if (loader->priv->pool)
+        {
+            g_thread_pool_free (loader->priv->pool, TRUE, FALSE);
+            loader->priv->pool = NULL;
+        }
+        if (loader->priv->pending)
+        {
+            g_hash_table_destroy (loader->priv->pending);
+            loader->priv->pending = NULL;
+        }
+        g_free (loader->priv);
+        loader->priv = NULL;
+    }
+}
+
+/**
+ * rstto_thumbnail_loader_finalize:
+ * @object:
+ *
+ */
+static void
+rstto_thumbnail_loader_finalize (GObject *object)
+{
+    if (loader_object == RSTTO_THUMBNAIL_LOADER (object))
+    {
+        loader_object = NULL;
+    }
+}
+
+
+
+/**
+ * rstto_thumbnail_loader_new:
+ *
+ *
+ * Singleton
+ */
+RsttoThumbnailLoader *
+rstto_thumbnail_loader_new (void)
+{
+    if (loader_object == NULL)
+    {
+        loader_object = g_object_new (RSTTO_TYPE_THUMBNAIL_LOADER, NULL);
+    }
+    else
+    {
+        g_object_ref (loader_object);
+    }
+
+    return loader_object;
+}
+
+/**
+ * rstto_thumbnail_loader_get_n_pending:
+ * @loader:
+ *
+ * Return value: the number of files that are being loaded.
+ */
+guint
+rstto_thumbnail_loader_get_n_pending (
+        RsttoThumbnailLoader *loader)
+{
+    g_return_val_if_fail (RSTTO_IS_THUMBNAIL_LOADER (loader), 0);
+
+    return g_hash_table_size (loader->priv->pending);
+}
+
+static RsttoThumbnailFlavor
+rstto_thumbnail_loader_other_flavor (RsttoThumbnailFlavor flavor)
+{
+    return (flavor == THUMBNAIL_FLAVOR_LARGE) ?
+            THUMBNAIL_FLAVOR_NORMAL : THUMBNAIL_FLAVOR_LARGE;
+}
+
+/**
+ * rstto_thumbnail_loader_load:
+ * @loader:
+ * @r_file:
+ * @size:
+ *
+ * Load the thumbnail of @r_file in the background, it is set on
+ * @r_file before the "ready" signal is emitted. Nothing is emitted
+ * if there is no thumbnail.
+ *
+ * The thumbnail is checked against the modification-time of @r_file,
+ * a missing or stale thumbnail is requested from the RsttoThumbnailer.
+ *
+ * Return value: FALSE if the thumbnail is being loaded already.
+ */
+gboolean
+rstto_thumbnail_loader_load (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *r_file,
+        RsttoThumbnailSize size)
+{
+    RsttoThumbnailRequest *request;
+    gboolean known;
+    guint mask;
+
+    g_return_val_if_fail (RSTTO_IS_THUMBNAIL_LOADER (loader), FALSE);
+    g_return_val_if_fail (RSTTO_IS_FILE (r_file), FALSE);
+
+    mask = GPOINTER_TO_UINT (g_hash_table_lookup (
+            loader->priv->pending,
+            r_file));
+    if (mask & (1 << size))
+    {
+        return FALSE;
+    }
+
+    /* The requests keep the file alive, the key is not referenced */
+    g_hash_table_insert (
+            loader->priv->pending,
+            r_file,
+            GUINT_TO_POINTER (mask | (1 << size)));
+
+    request = g_new0 (RsttoThumbnailRequest, 1);
+    request->loader = g_object_ref (loader);
+    request->r_file = g_object_ref (r_file);
+    request->size = size;
+    g_atomic_int_inc (&loader->priv->serial);
+    request->serial = g_atomic_int_get (&loader->priv->serial);
+    request->flavor = THUMBNAIL_SIZE_GET_FLAVOR (size);
+    request->path_flavor = request->flavor;
+    known = rstto_thumbnail_index_get_path (
+            rstto_file_get_uri (r_file),
+            request->flavor,
+            &request->path);
+    if ( (TRUE == known) && (NULL == request->path) )
+    {
+        /* Use the other flavor until this one is generated */
+        request->path_flavor = rstto_thumbnail_loader_other_flavor (request->flavor);
+        known = rstto_thumbnail_index_get_path (
+                rstto_file_get_uri (r_file),
+                request->path_flavor,
+                &request->path);
+    }
+    if (FALSE == known)
+    {
+        request->path_flavor = request->flavor;
+        request->uri = g_strdup (rstto_file_get_uri (r_file));
+    }
+    request->mtime = rstto_file_get_modified_time (r_file);
+
+    if ( (NULL == request->path) &&
+         (NULL != rstto_file_get_path (r_file)) &&
+         (0 == g_strcmp0 (rstto_file_get_content_type (r_file), "image/jpeg")) )
+    {
+        request->exif_path = g_strdup (rstto_file_get_path (r_file));
+    }
+
+    if ( (NULL == request->path) &&
+         (NULL == request->uri) &&
+         (NULL == request->exif_path) )
+    {
+        /* There is no thumbnail, nothing to load */
+        request->state = RSTTO_THUMBNAIL_STATE_QUEUED;
+        gdk_threads_add_idle (
+                cb_rstto_thumbnail_loader_request_done,
+                request);
+        return TRUE;
+    }
+
+    g_thread_pool_push (loader->priv->pool, request, NULL);
+
+    return TRUE;
+}
+
+static gint
+rstto_thumbnail_loader_compare_requests (
+        gconstpointer a,
+        gconstpointer b,
+        gpointer user_data)
+{
+    const RsttoThumbnailRequest *request_a = a;
+    const RsttoThumbnailRequest *request_b = b;
+
+    return request_b->serial - request_a->serial;
+}
+
+/**
+ * rstto_thumbnail_loader_read_embedded:
+ * @path:
+ *
+ * Only the headers of the image are read. Cameras pad the embedded
+ * thumbnail to 160x120, the bars are cropped off if the dimensions of
+ * the image are known.
+ *
+ * Return value: The embedded thumbnail of a JPEG image, oriented like
+ *               the image, or NULL.
+ */
+static GdkPixbuf *
+rstto_thumbnail_loader_read_embedded (
+        const gchar *path)
+{
+    RsttoMetadata metadata;
+    GdkPixbufLoader *pixbuf_loader;
+    GdkPixbufRotation rotation = GDK_PIXBUF_ROTATE_NONE;
+    GdkPixbuf *pixbuf = NULL;
+    GdkPixbuf *tmp_pixbuf;
+    gboolean flip = FALSE;
+    guchar *data = NULL;
+    gsize length = 0;
+    gint width;
+    gint height;
+    gint x;
+    gint y;
+
+    rstto_metadata_read_thumbnail (path, &metadata, &data, &length);
+    if (NULL == data)
+    {
+        rstto_metadata_clear (&metadata);
+        return NULL;
+    }
+
+    pixbuf_loader = gdk_pixbuf_loader_new ();
+    if (TRUE == gdk_pixbuf_loader_write (pixbuf_loader, data, length, NULL))
+    {
+        if (TRUE == gdk_pixbuf_loader_close (pixbuf_loader, NULL))
+        {
+            pixbuf = gdk_pixbuf_loader_get_pixbuf (pixbuf_loader);
+        }
+    }
+    else
+    {
+        gdk_pixbuf_loader_close (pixbuf_loader, NULL);
+    }
+
+    if (NULL != pixbuf)
+    {
+        g_object_ref (pixbuf);
+    }
+    g_object_unref (pixbuf_loader);
+    g_free (data);
+
+    if (NULL == pixbuf)
+    {
+        rstto_metadata_clear (&metadata);
+        return NULL;
+    }
+
+    if ( (metadata.width > 0) && (metadata.height > 0) )
+    {
+        width = gdk_pixbuf_get_width (pixbuf);
+        height = gdk_pixbuf_get_height (pixbuf);
+
+        if (width * metadata.height > height * metadata.width)
+        {
+            width = MAX (1, height * metadata.width / metadata.height);
+        }
+        else
+        {
+            height = MAX (1, width * metadata.height / metadata.width);
+        }
+
+        x = (gdk_pixbuf_get_width (pixbuf) - width) / 2;
+        y = (gdk_pixbuf_get_height (pixbuf) - height) / 2;
+        if ( (x > 0) || (y > 0) )
+        {
+            tmp_pixbuf = gdk_pixbuf_new_subpixbuf (
+                    pixbuf,
+                    x,
+                    y,
+                    width,
+                    height);
+            g_object_unref (pixbuf);
+            pixbuf = tmp_pixbuf;
+        }
+    }
+
+    /* Every orientation is a rotation, optionally followed by a
+     * horizontal flip.
+     */
+    switch (metadata.orientation)
+    {
+        case RSTTO_IMAGE_ORIENT_FLIP_HORIZONTAL:
+            flip = TRUE;
+            break;
+        case RSTTO_IMAGE_ORIENT_180:
+            rotation = GDK_PIXBUF_ROTATE_UPSIDEDOWN;
+            break;
+        case RSTTO_IMAGE_ORIENT_FLIP_VERTICAL:
+            rotation = GDK_PIXBUF_ROTATE_UPSIDEDOWN;
+            flip = TRUE;
+            break;
+        case RSTTO_IMAGE_ORIENT_FLIP_TRANSPOSE:
+            rotation = GDK_PIXBUF_ROTATE_CLOCKWISE;
+            flip = TRUE;
+            break;
+        case RSTTO_IMAGE_ORIENT_90:
+            rotation = GDK_PIXBUF_ROTATE_CLOCKWISE;
+            break;
+        case RSTTO_IMAGE_ORIENT_FLIP_TRANSVERSE:
+            rotation = GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE;
+            flip = TRUE;
+            break;
+        case RSTTO_IMAGE_ORIENT_270:
+            rotation = GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE;
+            break;
+        default:
+            break;
+    }
+
+    if (GDK_PIXBUF_ROTATE_NONE != rotation)
+    {
+        tmp_pixbuf = gdk_pixbuf_rotate_simple (pixbuf, rotation);
+        g_object_unref (pixbuf);
+        pixbuf = tmp_pixbuf;
+    }
+
+    if ( (NULL != pixbuf) && (TRUE == flip) )
+    {
+        tmp_pixbuf = gdk_pixbuf_flip (pixbuf, TRUE);
+        g_object_unref (pixbuf);
+        pixbuf = tmp_pixbuf;
+    }
+
+    rstto_metadata_clear (&metadata);
+
+    return pixbuf;
+}
+
+static void
+rstto_thumbnail_loader_thread (
+        gpointer data,
+        gpointer user_data)
+{
+    RsttoThumbnailRequest *request = data;
+    RsttoThumbnailLoader *loader = RSTTO_THUMBNAIL_LOADER (user_data);
+    GdkPixbuf *pixbuf = NULL;
+    const gchar *mtime;
+    gint width;
+    gint height;
+    gint size;
+
+    if ( (g_atomic_int_get (&loader->priv->serial) - request->serial) <
+         RSTTO_THUMBNAIL_LOADER_MAX_BACKLOG )
+    {
+        request->state = RSTTO_THUMBNAIL_STATE_QUEUED;
+
+        if (NULL != request->uri)
+        {
+            request->path = rstto_thumbnail_index_find_path (
+                    request->uri,
+                    request->flavor);
+            if (NULL == request->path)
+            {
+                request->path_flavor = rstto_thumbnail_loader_other_flavor (request->flavor);
+                request->path = rstto_thumbnail_index_find_path (
+                        request->uri,
+                        request->path_flavor);
+            }
+        }
+
+        if (NULL != request->path)
+        {
+            /* Not at scale, a scaled pixbuf loses the tEXt-chunks */
+            pixbuf = gdk_pixbuf_new_from_file (request->path, NULL);
+        }
+
+        if (NULL != pixbuf)
+        {
+            mtime = gdk_pixbuf_get_option (pixbuf, "tEXt::Thumb::MTime");
+
+            /* The modification-time is not known for every file */
+            if ( (0 == request->mtime) ||
+                 ( (NULL != mtime) &&
+                   (g_ascii_strtoull (mtime, NULL, 10) == request->mtime) ) )
+            {
+                request->state = RSTTO_THUMBNAIL_STATE_VALID;
+            }
+            else
+            {
+                request->state = RSTTO_THUMBNAIL_STATE_STALE;
+            }
+
+            /* A large thumbnail is fine for the normal flavor, a normal
+             * one is too small for the large flavor.
+             */
+            if ( (RSTTO_THUMBNAIL_STATE_VALID == request->state) &&
+                 (request->path_flavor < request->flavor) )
+            {
+                request->state = RSTTO_THUMBNAIL_STATE_STALE;
+            }
+        }
+        else if (NULL != request->exif_path)
+        {
+            /* Shown while the state remains queued */
+            pixbuf = rstto_thumbnail_loader_read_embedded (request->exif_path);
+        }
+
+        if (NULL != pixbuf)
+        {
+            width = gdk_pixbuf_get_width (pixbuf);
+            height = gdk_pixbuf_get_height (pixbuf);
+            size = rstto_thumbnail_size[request->size];
+
+            if (width > height)
+            {
+                height = MAX (1, height * size / width);
+                width = size;
+            }
+            else
+            {
+                width = MAX (1, width * size / height);
+                height = size;
+            }
+
+            /* Scaled once, the result is cached. Scaling up is only
+             * done until the right flavor is generated.
+             */
+            request->pixbuf = gdk_pixbuf_scale_simple (
+                    pixbuf,
+                    width,
+                    height,
+                    (width < gdk_pixbuf_get_width (pixbuf)) ?
+                            GDK_INTERP_HYPER : GDK_INTERP_BILINEAR);
+            g_object_unref (pixbuf);
+        }
+    }
+
+    gdk_threads_add_idle (
+            cb_rstto_thumbnail_loader_request_done,
+            request);
+}
+
+static gboolean
+cb_rstto_thumbnail_loader_request_done (
+        gpointer user_data)
+{
+    RsttoThumbnailRequest *request = user_data;
+    RsttoThumbnailLoader *loader = request->loader;
+    RsttoThumbnailer *thumbnailer;
+    RsttoThumbnailState state;
+    guint mask;
+
+    mask = GPOINTER_TO_UINT (g_hash_table_lookup (
+            loader->priv->pending,
+            request->r_file));
+    mask &= ~(1 << request->size);
+
+    if (0 == mask)
+    {
+        g_hash_table_remove (loader->priv->pending, request->r_file);
+    }
+    else
+    {
+        g_hash_table_insert (
+                loader->priv->pending,
+                request->r_file,
+                GUINT_TO_POINTER (mask));
+    }
+
+    if (NULL != request->pixbuf)
+    {
+        rstto_file_set_thumbnail (
+                request->r_file,
+                request->size,
+                request->pixbuf);
+        g_signal_emit (
+                G_OBJECT (loader),
+                rstto_thumbnail_loader_signals[RSTTO_THUMBNAIL_LOADER_SIGNAL_READY],
+                0,
+                request->r_file,
+                request->size,
+                NULL);
+        g_object_unref (request->pixbuf);
+    }
+
+    /* Ignore the state if the file changed while it was loading */
+    state = rstto_file_get_thumbnail_state (
+            request->r_file,
+            request->flavor);
+    if ( (RSTTO_THUMBNAIL_STATE_UNKNOWN != request->state) &&
+         (rstto_file_get_modified_time (request->r_file) == request->mtime) )
+    {
+        if (RSTTO_THUMBNAIL_STATE_VALID == request->state)
+        {
+            rstto_file_set_thumbnail_state (
+                    request->r_file,
+                    request->flavor,
+                    RSTTO_THUMBNAIL_STATE_VALID);
+        }
+        else if ( (RSTTO_THUMBNAIL_STATE_UNKNOWN == state) ||
+                  (RSTTO_THUMBNAIL_STATE_VALID == state) )
+        {
+            /* Only once, until the thumbnailer is done with it */
+            rstto_file_set_thumbnail_state (
+                    request->r_file,
+                    request->flavor,
+                    request->state);
+
+            thumbnailer = rstto_thumbnailer_new ();
+            rstto_thumbnailer_queue_file (
+                    thumbnailer,
+                    request->r_file,
+                    request->flavor);
+            g_object_unref (thumbnailer);
+        }
+    }
+
+    /* Loading is done, the placeholders are not needed anymore */
+    if (0 == g_hash_table_size (loader->priv->pending))
+    {
+        rstto_thumbnail_cache_purge ();
+    }
+
+    g_object_unref (request->r_file);
+    g_free (request->path);
+    g_free (request->uri);
+    g_free (request->exif_path);
+    g_free (request);
+
+    /* May be the last reference */
+    g_object_unref (loader);
+
+    return FALSE;
+}
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) Stephan Arts 2006-2012 <stephan@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ * 
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#ifndef __RISTRETTO_THUMBNAIL_LOADER_H__
+#define __RISTRETTO_THUMBNAIL_LOADER_H__
+
+G_BEGIN_DECLS
+
+#define RSTTO_TYPE_THUMBNAIL_LOADER rstto_thumbnail_loader_get_type()
+
+#define RSTTO_THUMBNAIL_LOADER(obj)( \
+        G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                RSTTO_TYPE_THUMBNAIL_LOADER, \
+                RsttoThumbnailLoader))
+
+#define RSTTO_IS_THUMBNAIL_LOADER(obj)( \
+        G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                RSTTO_TYPE_THUMBNAIL_LOADER))
+
+#define RSTTO_THUMBNAIL_LOADER_CLASS(klass)( \
+        G_TYPE_CHECK_CLASS_CAST ((klass), \
+                RSTTO_TYPE_THUMBNAIL_LOADER, \
+                RsttoThumbnailLoaderClass))
+
+#define RSTTO_IS_THUMBNAIL_LOADER_CLASS(klass)( \
+        G_TYPE_CHECK_CLASS_TYPE ((klass), \
+                RSTTO_TYPE_THUMBNAIL_LOADER()))
+
+
+typedef struct _RsttoThumbnailLoader RsttoThumbnailLoader;
+typedef struct _RsttoThumbnailLoaderPriv RsttoThumbnailLoaderPriv;
+
+struct _RsttoThumbnailLoader
+{
+    GObject parent;
+
+    RsttoThumbnailLoaderPriv *priv;
+};
+
+typedef struct _RsttoThumbnailLoaderClass RsttoThumbnailLoaderClass;
+
+struct _RsttoThumbnailLoaderClass
+{
+    GObjectClass parent_class;
+};
+
+RsttoThumbnailLoader *
+rstto_thumbnail_loader_new (void);
+
+GType
+rstto_thumbnail_loader_get_type (void);
+
+gboolean
+rstto_thumbnail_loader_load (
+        RsttoThumbnailLoader *loader,
+        RsttoFile *r_file,
+        RsttoThumbnailSize size);
+
+guint
+rstto_thumbnail_loader_get_n_pending (
+        RsttoThumbnailLoader *loader);
+
+G_END_DECLS
+
+#endif /* __RISTRETTO_THUMBNAIL_LOADER_H__ */
@@ -34,6 +34,8 @@
 #include "file.h"
 #include "settings.h"
 #include "thumbnailer.h"
+#include "thumbnail_generator.h"
+#include "thumbnail_index.h"
 #include "marshal.h"
 
 static void
@@ -62,17 +64,92 @@ rstto_thumbnailer_get_property (
 static void
 cb_rstto_thumbnailer_request_finished (
         DBusGProxy *proxy,
-        gint handle,
+        guint handle,
         gpointer data);
 static void
 cb_rstto_thumbnailer_thumbnail_ready (
         DBusGProxy *proxy,
-        gint handle,
+        guint handle,
         const gchar **uri,
         gpointer data);
 
 static gboolean
 rstto_thumbnailer_queue_request_timer (RsttoThumbnailer *thumbnailer);
+static void
+rstto_thumbnailer_queue_request (
+        RsttoThumbnailer *thumbnailer,
+        RsttoThumbnailFlavor flavor);
+static gint
+rstto_thumbnailer_compare_files (
+        gconstpointer a,
+        gconstpointer b,
+        gpointer user_data);
+
+typedef struct _RsttoThumbnailerRequest RsttoThumbnailerRequest;
+
+/* A Queue-request to the thumbnailing-service */
+struct _RsttoThumbnailerRequest
+{
+    RsttoThumbnailer *thumbnailer;
+    RsttoThumbnailFlavor flavor;
+
+    /* The files that are not ready yet, referenced */
+    GSList           *files;
+
+    /* Set while the reply is pending */
+    DBusGProxyCall   *call;
+    guint             handle;
+};
+
+typedef struct _RsttoThumbnailerEntry RsttoThumbnailerEntry;
+
+/* A file that is queued, or sent to the thumbnailing-service */
+struct _RsttoThumbnailerEntry
+{
+    /* NULL while the file is in the queue */
+    RsttoThumbnailerRequest *request;
+};
+
+static gint
+rstto_thumbnailer_get_position (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file);
+static void
+rstto_thumbnailer_dequeue_entry (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor,
+        RsttoThumbnailerRequest *request);
+static gint
+rstto_thumbnailer_get_distance (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file);
+
+static void
+cb_rstto_thumbnailer_queue_reply (
+        DBusGProxy *proxy,
+        DBusGProxyCall *call,
+        gpointer user_data);
+static void
+rstto_thumbnailer_request_free (
+        RsttoThumbnailerRequest *request);
+
+static void
+rstto_thumbnailer_generate (
+        RsttoThumbnailer *thumbnailer,
+        GSList *files,
+        RsttoThumbnailFlavor flavor);
+static void
+cb_rstto_thumbnailer_generator_done (
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor,
+        gboolean success,
+        gpointer user_data);
+static void
+cb_rstto_thumbnailer_use_internal_changed (
+        GObject *settings,
+        GParamSpec *pspec,
+        gpointer user_data);
 
 static GObjectClass *parent_class = NULL;
 
@@ -127,12 +204,32 @@ struct _RsttoThumbnailerPriv
     DBusGProxy        *proxy;
     RsttoSettings     *settings;
 
-    GSList            *queue;
+    /* Files that are not sent yet per flavor, referenced */
+    GSList            *queue[THUMBNAIL_FLAVOR_COUNT];
 
-    GSList            *in_process_queue;
-    gint               handle;
+    /* RsttoFile -> RsttoThumbnailerEntry per flavor */
+    GHashTable        *files[THUMBNAIL_FLAVOR_COUNT];
 
-    gboolean           show_missing_thumbnailer_error;
+    /* Handle -> RsttoThumbnailerRequest */
+    GHashTable        *requests;
+
+    /* Requests waiting for a reply */
+    GSList            *pending_requests;
+
+    /* RsttoFile -> position in the icon-bar, referenced. The icon-bar
+     * sets the position before the thumbnail-loader queues the file,
+     * so it is kept apart from the queued files.
+     */
+    GHashTable        *positions;
+
+    /* The items that are visible in the icon-bar, -1 if unknown */
+    gint               visible_first;
+    gint               visible_last;
+    gint               active_position;
+
+    /* Generate the thumbnails without the thumbnailing-service */
+    gboolean           use_internal;
+    gboolean           service_unknown;
 
     gint request_timer_id;
 };
@@ -141,15 +238,43 @@ static void
 rstto_thumbnailer_init (GObject *object)
 {
     RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (object);
+    gint i;
 
     thumbnailer->priv = g_new0 (RsttoThumbnailerPriv, 1);
     thumbnailer->priv->connection = dbus_g_bus_get(DBUS_BUS_SESSION, NULL);
     thumbnailer->priv->settings = rstto_settings_new();
+    for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+    {
+        thumbnailer->priv->files[i] = g_hash_table_new_full (
+                g_direct_hash,
+                g_direct_equal,
+                NULL,
+                g_free);
+    }
+    thumbnailer->priv->positions = g_hash_table_new_full (
+            g_direct_hash,
+            g_direct_equal,
+            g_object_unref,
+            NULL);
+    thumbnailer->priv->visible_first = -1;
+    thumbnailer->priv->visible_last = -1;
+    thumbnailer->priv->active_position = -1;
+    thumbnailer->priv->requests = g_hash_table_new_full (
+            g_direct_hash,
+            g_direct_equal,
+            NULL,
+            (GDestroyNotify) rstto_thumbnailer_request_free);
 
-    thumbnailer->priv->show_missing_thumbnailer_error =
+    thumbnailer->priv->use_internal =
             rstto_settings_get_boolean_property (
                     thumbnailer->priv->settings,
-                    "show-error-missing-thumbnailer");
+                    "use-internal-thumbnailer");
+
+    g_signal_connect (
+            G_OBJECT (thumbnailer->priv->settings),
+            "notify::use-internal-thumbnailer",
+            G_CALLBACK (cb_rstto_thumbnailer_use_internal_changed),
+            thumbnailer);
 
     if (thumbnailer->priv->connection)
     {
@@ -232,14 +357,72 @@ static void
 rstto_thumbnailer_dispose (GObject *object)
 {
     RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (object);
+    RsttoThumbnailerRequest *request;
+    GSList *iter;
+    gint i;
 
     if (thumbnailer->priv)
     {
         if (thumbnailer->priv->settings)
         {
+            g_signal_handlers_disconnect_by_func (
+                    thumbnailer->priv->settings,
+                    cb_rstto_thumbnailer_use_internal_changed,
+                    thumbnailer);
             g_object_unref (thumbnailer->priv->settings);
             thumbnailer->priv->settings = NULL;
         }
+        if (thumbnailer->priv->request_timer_id)
+        {
+            g_source_remove (thumbnailer->priv->request_timer_id);
+            thumbnailer->priv->request_timer_id = 0;
+        }
+        if (thumbnailer->priv->proxy)
+        {
+            for (iter = thumbnailer->priv->pending_requests; iter != NULL; iter = g_slist_next (iter))
+            {
+                request = iter->data;
+                dbus_g_proxy_cancel_call (thumbnailer->priv->proxy, request->call);
+                rstto_thumbnailer_request_free (request);
+            }
+            g_slist_free (thumbnailer->priv->pending_requests);
+            thumbnailer->priv->pending_requests = NULL;
+
+            dbus_g_proxy_disconnect_signal (
+                    thumbnailer->priv->proxy,
+                    "Finished",
+                    G_CALLBACK (cb_rstto_thumbnailer_request_finished),
+                    thumbnailer);
+            dbus_g_proxy_disconnect_signal (
+                    thumbnailer->priv->proxy,
+                    "Ready",
+                    G_CALLBACK (cb_rstto_thumbnailer_thumbnail_ready),
+                    thumbnailer);
+            g_object_unref (thumbnailer->priv->proxy);
+            thumbnailer->priv->proxy = NULL;
+        }
+        if (thumbnailer->priv->requests)
+        {
+            g_hash_table_destroy (thumbnailer->priv->requests);
+            thumbnailer->priv->requests = NULL;
+        }
+        if (thumbnailer->priv->positions)
+        {
+            g_hash_table_destroy (thumbnailer->priv->positions);
+            thumbnailer->priv->positions = NULL;
+        }
+        for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+        {
+            if (thumbnailer->priv->files[i])
+            {
+                g_hash_table_destroy (thumbnailer->priv->files[i]);
+                thumbnailer->priv->files[i] = NULL;
+            }
+            g_slist_foreach (thumbnailer->priv->queue[i], (GFunc)g_object_unref, NULL);
+            g_slist_free (thumbnailer->priv->queue[i]);
+            thumbnailer->priv->queue[i] = NULL;
+        }
+
         g_free (thumbnailer->priv);
         thumbnailer->priv = NULL;
     }
@@ -307,45 +490,52 @@ rstto_thumbnailer_get_property (
     }
 }
 
+/**
+ * rstto_thumbnailer_queue_file:
+ * @thumbnailer:
+ * @file:
+ * @flavor: the thumbnail-flavor to generate
+ *
+ */
 void
 rstto_thumbnailer_queue_file (
         RsttoThumbnailer *thumbnailer,
-        RsttoFile *file )
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor )
 {
+    RsttoThumbnailerEntry *entry;
+
     g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
 
     g_return_if_fail ( RSTTO_IS_FILE (file) );
 
-    if (thumbnailer->priv->request_timer_id)
+    /* Already queued, or sent to the thumbnailing-service */
+    if (NULL != g_hash_table_lookup (thumbnailer->priv->files[flavor], file))
     {
-        g_source_remove (thumbnailer->priv->request_timer_id);
-        if (thumbnailer->priv->handle)
-        {
-            if(dbus_g_proxy_call(thumbnailer->priv->proxy,
-                    "Dequeue",
-                    NULL,
-                    G_TYPE_UINT, thumbnailer->priv->handle,
-                    G_TYPE_INVALID) == FALSE)
-            {
-            }
-            thumbnailer->priv->handle = 0;
-        }
+        return;
     }
 
-    if (g_slist_find (thumbnailer->priv->queue, file) == NULL)
+    entry = g_new0 (RsttoThumbnailerEntry, 1);
+
+    g_object_ref (file);
+    thumbnailer->priv->queue[flavor] = g_slist_prepend (
+            thumbnailer->priv->queue[flavor],
+            file);
+    g_hash_table_insert (thumbnailer->priv->files[flavor], file, entry);
+
+    /* Collect the files that are requested in a short period of
+     * time, they are sent in a single request. The timer is not
+     * restarted, continuous scrolling does not postpone it.
+     */
+    if (0 == thumbnailer->priv->request_timer_id)
     {
-        g_object_ref (file);
-        thumbnailer->priv->queue = g_slist_prepend (
-                thumbnailer->priv->queue,
-                file);
+        thumbnailer->priv->request_timer_id = g_timeout_add_full (
+                G_PRIORITY_LOW,
+                300,
+                (GSourceFunc)rstto_thumbnailer_queue_request_timer,
+                thumbnailer,
+                NULL);
     }
-
-    thumbnailer->priv->request_timer_id = g_timeout_add_full (
-            G_PRIORITY_LOW,
-            300,
-            (GSourceFunc)rstto_thumbnailer_queue_request_timer,
-            thumbnailer,
-            NULL);
 }
 
 void
@@ -353,72 +543,321 @@ rstto_thumbnailer_dequeue_file (
         RsttoThumbnailer *thumbnailer,
         RsttoFile *file)
 {
+    RsttoThumbnailerRequest *request;
+    RsttoThumbnailerEntry *entry;
+    gint i;
+
     g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
 
     g_return_if_fail ( RSTTO_IS_FILE (file) );
-    
-    if (thumbnailer->priv->request_timer_id)
+
+    rstto_thumbnail_generator_dequeue_file (file);
+
+    /* The queues may hold the last references */
+    g_object_ref (file);
+
+    for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
     {
-        g_source_remove (thumbnailer->priv->request_timer_id);
+        entry = g_hash_table_lookup (thumbnailer->priv->files[i], file);
+        if (NULL != entry)
+        {
+            rstto_thumbnailer_dequeue_entry (thumbnailer, file, i, entry->request);
+        }
+        else if ( (RSTTO_THUMBNAIL_STATE_QUEUED == rstto_file_get_thumbnail_state (file, i)) ||
+                  (RSTTO_THUMBNAIL_STATE_STALE == rstto_file_get_thumbnail_state (file, i)) )
+        {
+            /* Handed to the generator, requested again when it is
+             * needed instead of being marked as failed.
+             */
+            rstto_file_set_thumbnail_state (file, i, RSTTO_THUMBNAIL_STATE_UNKNOWN);
+        }
     }
 
-    if (thumbnailer->priv->handle)
+    g_object_unref (file);
+}
+
+static void
+rstto_thumbnailer_dequeue_entry (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor,
+        RsttoThumbnailerRequest *request)
+{
+    g_hash_table_remove (thumbnailer->priv->files[flavor], file);
+
+    /* Requested again when it is needed */
+    rstto_file_set_thumbnail_state (file, flavor, RSTTO_THUMBNAIL_STATE_UNKNOWN);
+
+    if (NULL == request)
     {
-        if(dbus_g_proxy_call(thumbnailer->priv->proxy,
-                "Dequeue",
-                NULL,
-                G_TYPE_UINT, thumbnailer->priv->handle,
-                G_TYPE_INVALID) == FALSE)
+        /* Not sent yet */
+        thumbnailer->priv->queue[flavor] = g_slist_remove (
+                thumbnailer->priv->queue[flavor],
+                file);
+    }
+    else
+    {
+        request->files = g_slist_remove (request->files, file);
+
+        /* The service works on a whole request, it can only be
+         * dequeued when none of its files are needed anymore.
+         * If the handle is not known yet, this is done when the
+         * reply arrives.
+         */
+        if ( (NULL == request->files) && (NULL == request->call) )
         {
+            dbus_g_proxy_call_no_reply (
+                    thumbnailer->priv->proxy,
+                    "Dequeue",
+                    G_TYPE_UINT, request->handle,
+                    G_TYPE_INVALID);
+            g_hash_table_remove (
+                    thumbnailer->priv->requests,
+                    GUINT_TO_POINTER (request->handle));
         }
-        thumbnailer->priv->handle = 0;
-        g_slist_foreach (thumbnailer->priv->in_process_queue, (GFunc)g_object_unref, NULL);
-        g_slist_free (thumbnailer->priv->in_process_queue);
-        thumbnailer->priv->in_process_queue = NULL;
     }
 
-    if (g_slist_find (thumbnailer->priv->queue, file) != NULL)
+    g_object_unref (file);
+}
+
+/**
+ * rstto_thumbnailer_set_position:
+ * @thumbnailer:
+ * @file:
+ * @position: index of the item of @file in the icon-bar
+ *
+ * Queued files are sent in the order of their distance to the
+ * visible items, files without a position go first. The position
+ * can be set before @file is queued, it is kept until @file scrolls
+ * out of range.
+ */
+void
+rstto_thumbnailer_set_position (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file,
+        gint position)
+{
+    g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
+
+    /* If @file is already known the extra reference is released */
+    g_hash_table_insert (
+            thumbnailer->priv->positions,
+            g_object_ref (file),
+            GINT_TO_POINTER (position));
+}
+
+/**
+ * rstto_thumbnailer_set_visible_range:
+ * @thumbnailer:
+ * @first: index of the first visible item
+ * @last: index of the last visible item
+ * @active: index of the active item, or -1
+ *
+ * Files that are more than a page, plus the number of prefetched
+ * items, away from the visible items and from the active item are
+ * dequeued, they have scrolled out of range.
+ */
+void
+rstto_thumbnailer_set_visible_range (
+        RsttoThumbnailer *thumbnailer,
+        gint first,
+        gint last,
+        gint active)
+{
+    GHashTableIter iter;
+    GSList *out_of_range = NULL;
+    GSList *file_iter;
+    gpointer key;
+    gint margin;
+
+    g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
+
+    margin = last - first + 1 + rstto_settings_get_uint_property (
+            thumbnailer->priv->settings,
+            "thumbnail-prefetch");
+
+    thumbnailer->priv->visible_first = first;
+    thumbnailer->priv->visible_last = last;
+    thumbnailer->priv->active_position = active;
+
+    /* Every file the icon-bar asked for has a position, whether it is
+     * queued, sent to the thumbnailing-service or being generated.
+     */
+    g_hash_table_iter_init (&iter, thumbnailer->priv->positions);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
     {
-        thumbnailer->priv->queue = g_slist_remove_all (
-                thumbnailer->priv->queue,
-                file);
-        g_object_unref (file);
+        if (rstto_thumbnailer_get_distance (thumbnailer, key) > margin)
+        {
+            out_of_range = g_slist_prepend (out_of_range, g_object_ref (key));
+            g_hash_table_iter_remove (&iter);
+        }
     }
 
-    thumbnailer->priv->request_timer_id = g_timeout_add_full (
-            G_PRIORITY_LOW,
-            300,
-            (GSourceFunc)rstto_thumbnailer_queue_request_timer,
-            thumbnailer,
-            NULL);
+    for (file_iter = out_of_range; file_iter != NULL; file_iter = g_slist_next (file_iter))
+    {
+        rstto_thumbnailer_dequeue_file (thumbnailer, file_iter->data);
+        g_object_unref (file_iter->data);
+    }
+    g_slist_free (out_of_range);
+}
+
+/**
+ * rstto_thumbnailer_get_position:
+ * @thumbnailer:
+ * @file:
+ *
+ * Return value: the position of @file in the icon-bar, -1 if unknown.
+ */
+static gint
+rstto_thumbnailer_get_position (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file)
+{
+    gpointer position;
+
+    if (TRUE == g_hash_table_lookup_extended (
+            thumbnailer->priv->positions,
+            file,
+            NULL,
+            &position))
+    {
+        return GPOINTER_TO_INT (position);
+    }
+
+    return -1;
+}
+
+/**
+ * rstto_thumbnailer_get_distance:
+ * @thumbnailer:
+ * @file:
+ *
+ * Return value: the number of items between @file and the visible
+ *               items, or the active item if that is closer.
+ */
+static gint
+rstto_thumbnailer_get_distance (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file)
+{
+    gint distance = 0;
+    gint position;
+
+    position = rstto_thumbnailer_get_position (thumbnailer, file);
+    if ( (position < 0) ||
+         (thumbnailer->priv->visible_first < 0) )
+    {
+        return 0;
+    }
+
+    if (position < thumbnailer->priv->visible_first)
+    {
+        distance = thumbnailer->priv->visible_first - position;
+    }
+    else if (position > thumbnailer->priv->visible_last)
+    {
+        distance = position - thumbnailer->priv->visible_last;
+    }
+
+    if (thumbnailer->priv->active_position >= 0)
+    {
+        distance = MIN (distance, ABS (position - thumbnailer->priv->active_position));
+    }
+
+    return distance;
+}
+
+static gint
+rstto_thumbnailer_compare_files (
+        gconstpointer a,
+        gconstpointer b,
+        gpointer user_data)
+{
+    RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (user_data);
+
+    return rstto_thumbnailer_get_distance (thumbnailer, RSTTO_FILE (a)) -
+           rstto_thumbnailer_get_distance (thumbnailer, RSTTO_FILE (b));
 }
 
 static gboolean
 rstto_thumbnailer_queue_request_timer (
         RsttoThumbnailer *thumbnailer)
 {
+    gint i;
+
+    g_return_val_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer), FALSE);
+
+    thumbnailer->priv->request_timer_id = 0;
+
+    for (i = 0; i < THUMBNAIL_FLAVOR_COUNT; ++i)
+    {
+        if (NULL != thumbnailer->priv->queue[i])
+        {
+            rstto_thumbnailer_queue_request (thumbnailer, i);
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * rstto_thumbnailer_queue_request:
+ * @thumbnailer:
+ * @flavor:
+ *
+ * Send the queued files of @flavor in a single request.
+ */
+static void
+rstto_thumbnailer_queue_request (
+        RsttoThumbnailer *thumbnailer,
+        RsttoThumbnailFlavor flavor)
+{
+    RsttoThumbnailerRequest *request;
+    RsttoThumbnailerEntry *entry;
     const gchar **uris;
     const gchar **mimetypes;
     GSList *iter;
     gint i = 0;
     RsttoFile *file;
-    GError *error = NULL;
-    GtkWidget *error_dialog = NULL;
-    GtkWidget *vbox, *do_not_show_checkbox;
 
-    g_return_val_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer), FALSE);
+    /* Closest to the visible items first */
+    thumbnailer->priv->queue[flavor] = g_slist_sort_with_data (
+            thumbnailer->priv->queue[flavor],
+            rstto_thumbnailer_compare_files,
+            thumbnailer);
+
+    if ( (TRUE == thumbnailer->priv->use_internal) ||
+         (TRUE == thumbnailer->priv->service_unknown) ||
+         (NULL == thumbnailer->priv->proxy) )
+    {
+        for (iter = thumbnailer->priv->queue[flavor]; iter != NULL; iter = g_slist_next (iter))
+        {
+            g_hash_table_remove (thumbnailer->priv->files[flavor], iter->data);
+        }
+
+        /* The generator starts with the file that was queued last */
+        rstto_thumbnailer_generate (
+                thumbnailer,
+                g_slist_reverse (thumbnailer->priv->queue[flavor]),
+                flavor);
+        thumbnailer->priv->queue[flavor] = NULL;
+        return;
+    }
 
-    thumbnailer->priv->in_process_queue = thumbnailer->priv->queue;
-    thumbnailer->priv->queue = NULL;
+    request = g_new0 (RsttoThumbnailerRequest, 1);
+    request->thumbnailer = thumbnailer;
+    request->flavor = flavor;
+    request->files = thumbnailer->priv->queue[flavor];
+    thumbnailer->priv->queue[flavor] = NULL;
 
     uris = g_new0 (
             const gchar *,
-            g_slist_length(thumbnailer->priv->in_process_queue) + 1);
+            g_slist_length(request->files) + 1);
     mimetypes = g_new0 (
             const gchar *,
-            g_slist_length (thumbnailer->priv->in_process_queue) + 1);
+            g_slist_length (request->files) + 1);
 
-    iter = thumbnailer->priv->in_process_queue;
+    iter = request->files;
     while (iter)
     {
         if (iter->data)
@@ -426,138 +865,283 @@ rstto_thumbnailer_queue_request_timer (
             file = RSTTO_FILE(iter->data);
             uris[i] = rstto_file_get_uri (file);
             mimetypes[i] = rstto_file_get_content_type (file);
+
+            entry = g_hash_table_lookup (thumbnailer->priv->files[flavor], file);
+            entry->request = request;
         }
         iter = g_slist_next(iter);
         i++;
     }
 
-    if(dbus_g_proxy_call(thumbnailer->priv->proxy,
+    /* The main-loop never waits for the service, the handle is
+     * known when the reply arrives. Several requests can be in
+     * flight at once.
+     */
+    request->call = dbus_g_proxy_begin_call (
+            thumbnailer->priv->proxy,
             "Queue",
-            &error,
+            cb_rstto_thumbnailer_queue_reply,
+            request,
+            NULL,
             G_TYPE_STRV, uris,
             G_TYPE_STRV, mimetypes,
-            G_TYPE_STRING, "normal",
+            G_TYPE_STRING, (flavor == THUMBNAIL_FLAVOR_LARGE) ? "large" : "normal",
             G_TYPE_STRING, "default",
             G_TYPE_UINT, 0,
-            G_TYPE_INVALID,
-            G_TYPE_UINT, &thumbnailer->priv->handle,
-            G_TYPE_INVALID) == FALSE)
+            G_TYPE_INVALID);
+
+    thumbnailer->priv->pending_requests = g_slist_prepend (
+            thumbnailer->priv->pending_requests,
+            request);
+
+    g_free (uris);
+    g_free (mimetypes);
+}
+
+static void
+cb_rstto_thumbnailer_queue_reply (
+        DBusGProxy *proxy,
+        DBusGProxyCall *call,
+        gpointer user_data)
+{
+    RsttoThumbnailerRequest *request = user_data;
+    RsttoThumbnailer *thumbnailer = request->thumbnailer;
+    GError *error = NULL;
+    GSList *iter;
+
+    thumbnailer->priv->pending_requests = g_slist_remove (
+            thumbnailer->priv->pending_requests,
+            request);
+    request->call = NULL;
+
+    if (FALSE == dbus_g_proxy_end_call (
+            proxy,
+            call,
+            &error,
+            G_TYPE_UINT, &request->handle,
+            G_TYPE_INVALID))
     {
+        for (iter = request->files; iter != NULL; iter = g_slist_next (iter))
+        {
+            g_hash_table_remove (thumbnailer->priv->files[request->flavor], iter->data);
+            rstto_file_set_thumbnail_state (
+                    RSTTO_FILE (iter->data),
+                    request->flavor,
+                    RSTTO_THUMBNAIL_STATE_FAILED);
+        }
+
         if (NULL != error)
         {
             g_warning("DBUS-call failed:%s", error->message);
             if ((error->domain == DBUS_GERROR) &&
-                (error->code == DBUS_GERROR_SERVICE_UNKNOWN) &&
-                thumbnailer->priv->show_missing_thumbnailer_error == TRUE)
+                (error->code == DBUS_GERROR_SERVICE_UNKNOWN))
             {
-                GDK_THREADS_ENTER();
-
-                error_dialog = gtk_message_dialog_new_with_markup (
-                        NULL,
-                        0,
-                        GTK_MESSAGE_WARNING,
-                        GTK_BUTTONS_OK,
-                        _("The thumbnailer-service can not be reached,\n"
-                        "for this reason, the thumbnails can not be\n"
-                        "created.\n\n"
-                        "Install <b>Tumbler</b> or another <i>thumbnailing daemon</i>\n"
-                        "to resolve this issue.")
-                        );
-                vbox = gtk_dialog_get_content_area (
-                        GTK_DIALOG (error_dialog));
-
-                do_not_show_checkbox = gtk_check_button_new_with_mnemonic (
-                        _("Do _not show this message again"));
-                gtk_box_pack_end (
-                        GTK_BOX (vbox),
-                        do_not_show_checkbox,
-                        TRUE,
-                        FALSE,
-                        0);
-                gtk_widget_show (do_not_show_checkbox);
-                gtk_dialog_run (GTK_DIALOG(error_dialog));
-
-                thumbnailer->priv->show_missing_thumbnailer_error = FALSE;
-                if (TRUE == gtk_toggle_button_get_active (
-                        GTK_TOGGLE_BUTTON (do_not_show_checkbox)))
-                {
-                    rstto_settings_set_boolean_property (
-                        thumbnailer->priv->settings,
-                        "show-error-missing-thumbnailer",
-                         FALSE);
-                }
-                gtk_widget_destroy (error_dialog);
-                GDK_THREADS_LEAVE();
+                /* There is no thumbnailing-service, generate the
+                 * thumbnails from now on.
+                 */
+                thumbnailer->priv->service_unknown = TRUE;
+                rstto_thumbnailer_generate (
+                        thumbnailer,
+                        request->files,
+                        request->flavor);
+                request->files = NULL;
             }
+            g_error_free (error);
         }
-        /* TOOO: Nice cleanup */
+
+        rstto_thumbnailer_request_free (request);
+        return;
     }
-    
-    thumbnailer->priv->request_timer_id = 0;
-    return FALSE;
+
+    if (NULL == request->files)
+    {
+        /* All files were dequeued in the meantime */
+        dbus_g_proxy_call_no_reply (
+                proxy,
+                "Dequeue",
+                G_TYPE_UINT, request->handle,
+                G_TYPE_INVALID);
+        rstto_thumbnailer_request_free (request);
+        return;
+    }
+
+    g_hash_table_insert (
+            thumbnailer->priv->requests,
+            GUINT_TO_POINTER (request->handle),
+            request);
+}
+
+static void
+rstto_thumbnailer_request_free (
+        RsttoThumbnailerRequest *request)
+{
+    g_slist_foreach (request->files, (GFunc)g_object_unref, NULL);
+    g_slist_free (request->files);
+    g_free (request);
+}
+
+/**
+ * rstto_thumbnailer_generate:
+ * @thumbnailer:
+ * @files: List of RsttoFiles, the list and the references are taken over.
+ * @flavor:
+ *
+ * Generate the thumbnails with the internal thumbnailer.
+ */
+static void
+rstto_thumbnailer_generate (
+        RsttoThumbnailer *thumbnailer,
+        GSList *files,
+        RsttoThumbnailFlavor flavor)
+{
+    GSList *iter;
+
+    for (iter = files; iter != NULL; iter = g_slist_next (iter))
+    {
+        /* Every request keeps the thumbnailer alive */
+        if (TRUE == rstto_thumbnail_generator_queue_file (
+                RSTTO_FILE (iter->data),
+                flavor,
+                cb_rstto_thumbnailer_generator_done,
+                thumbnailer))
+        {
+            g_object_ref (thumbnailer);
+        }
+        g_object_unref (iter->data);
+    }
+
+    g_slist_free (files);
+}
+
+static void
+cb_rstto_thumbnailer_generator_done (
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor,
+        gboolean success,
+        gpointer user_data)
+{
+    RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (user_data);
+
+    if (TRUE == success)
+    {
+        rstto_thumbnail_index_update (rstto_file_get_uri (file), flavor);
+        rstto_file_set_thumbnail_state (file, flavor, RSTTO_THUMBNAIL_STATE_UNKNOWN);
+        g_signal_emit (
+                G_OBJECT (thumbnailer),
+                rstto_thumbnailer_signals[RSTTO_THUMBNAILER_SIGNAL_READY],
+                0,
+                file,
+                NULL);
+    }
+    else if (RSTTO_THUMBNAIL_STATE_UNKNOWN != rstto_file_get_thumbnail_state (file, flavor))
+    {
+        /* Not dequeued */
+        rstto_file_set_thumbnail_state (file, flavor, RSTTO_THUMBNAIL_STATE_FAILED);
+    }
+
+    g_object_unref (thumbnailer);
+}
+
+static void
+cb_rstto_thumbnailer_use_internal_changed (
+        GObject *settings,
+        GParamSpec *pspec,
+        gpointer user_data)
+{
+    RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (user_data);
+
+    thumbnailer->priv->use_internal =
+            rstto_settings_get_boolean_property (
+                    RSTTO_SETTINGS (settings),
+                    "use-internal-thumbnailer");
 }
 
 static void
 cb_rstto_thumbnailer_request_finished (
         DBusGProxy *proxy,
-        gint handle,
+        guint handle,
         gpointer data)
 {
     RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (data);
+    RsttoThumbnailerRequest *request;
+    GSList *iter;
 
     g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
 
-    if (thumbnailer->priv->in_process_queue)
+    request = g_hash_table_lookup (
+            thumbnailer->priv->requests,
+            GUINT_TO_POINTER (handle));
+    if (NULL == request)
     {
-        g_slist_foreach (thumbnailer->priv->in_process_queue, (GFunc)g_object_unref, NULL);
-        g_slist_free (thumbnailer->priv->in_process_queue);
-        thumbnailer->priv->in_process_queue = NULL;
+        return;
     }
+
+    /* The service is done, there was an error for the files that
+     * are left.
+     */
+    for (iter = request->files; iter != NULL; iter = g_slist_next (iter))
+    {
+        g_hash_table_remove (thumbnailer->priv->files[request->flavor], iter->data);
+        rstto_file_set_thumbnail_state (
+                RSTTO_FILE (iter->data),
+                request->flavor,
+                RSTTO_THUMBNAIL_STATE_FAILED);
+    }
+
+    g_hash_table_remove (
+            thumbnailer->priv->requests,
+            GUINT_TO_POINTER (handle));
 }
 
 static void
 cb_rstto_thumbnailer_thumbnail_ready (
         DBusGProxy *proxy,
-        gint handle,
+        guint handle,
         const gchar **uri,
         gpointer data)
 {
     RsttoThumbnailer *thumbnailer = RSTTO_THUMBNAILER (data);
+    RsttoThumbnailerRequest *request;
     RsttoFile *file;
-    GSList *iter = thumbnailer->priv->in_process_queue;
-    gint x = 0;
-    const gchar *f_uri;
+    GSList *iter;
+    gint x;
 
     g_return_if_fail ( RSTTO_IS_THUMBNAILER (thumbnailer) );
 
-    while (iter)
+    request = g_hash_table_lookup (
+            thumbnailer->priv->requests,
+            GUINT_TO_POINTER (handle));
+    if (NULL == request)
     {
-        if ((uri[x] == NULL) || (iter->data == NULL))
-        {
-            break;
-        }
+        return;
+    }
 
-        file = RSTTO_FILE (iter->data);
-        f_uri = rstto_file_get_uri (file);
-        if (strcmp (uri[x], f_uri) == 0)
-        {
-            g_signal_emit (
-                    G_OBJECT (thumbnailer),
-                    rstto_thumbnailer_signals[RSTTO_THUMBNAILER_SIGNAL_READY],
-                    0,
-                    file,
-                    NULL);
-            thumbnailer->priv->in_process_queue = g_slist_remove (
-                    thumbnailer->priv->in_process_queue,
-                    file);
-            g_object_unref (file);
-
-            iter = thumbnailer->priv->in_process_queue;
-            x++;
-        }
-        else
+    for (x = 0; uri[x] != NULL; ++x)
+    {
+        for (iter = request->files; iter != NULL; iter = g_slist_next (iter))
         {
-            iter = g_slist_next(iter);
+            file = RSTTO_FILE (iter->data);
+            if (strcmp (uri[x], rstto_file_get_uri (file)) == 0)
+            {
+                request->files = g_slist_delete_link (request->files, iter);
+                g_hash_table_remove (thumbnailer->priv->files[request->flavor], file);
+
+                /* Load the new thumbnail */
+                rstto_thumbnail_index_update (uri[x], request->flavor);
+                rstto_file_set_thumbnail_state (
+                        file,
+                        request->flavor,
+                        RSTTO_THUMBNAIL_STATE_UNKNOWN);
+
+                g_signal_emit (
+                        G_OBJECT (thumbnailer),
+                        rstto_thumbnailer_signals[RSTTO_THUMBNAILER_SIGNAL_READY],
+                        0,
+                        file,
+                        NULL);
+                g_object_unref (file);
+                break;
+            }
         }
-    } 
+    }
 }
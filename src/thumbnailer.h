@@ -69,12 +69,25 @@ rstto_thumbnailer_get_type (void);
 void
 rstto_thumbnailer_queue_file (
         RsttoThumbnailer *thumbnailer,
-        RsttoFile *file);
+        RsttoFile *file,
+        RsttoThumbnailFlavor flavor);
 void
 rstto_thumbnailer_dequeue_file (
         RsttoThumbnailer *thumbnailer,
         RsttoFile *file );
 
+void
+rstto_thumbnailer_set_position (
+        RsttoThumbnailer *thumbnailer,
+        RsttoFile *file,
+        gint position);
+void
+rstto_thumbnailer_set_visible_range (
+        RsttoThumbnailer *thumbnailer,
+        gint first,
+        gint last,
+        gint active);
+
 G_END_DECLS
 
 #endif /* __RISTRETTO_THUMBNAILER_H__ */
@@ -68,6 +68,30 @@ typedef enum {
     THUMBNAIL_SIZE_COUNT,
 } RsttoThumbnailSize;
 
+/* The flavors of the freedesktop.org thumbnail-cache */
+typedef enum {
+    THUMBNAIL_FLAVOR_NORMAL = 0,
+    THUMBNAIL_FLAVOR_LARGE,
+    THUMBNAIL_FLAVOR_COUNT,
+} RsttoThumbnailFlavor;
+
+#define THUMBNAIL_FLAVOR_NORMAL_SIZE    128
+#define THUMBNAIL_FLAVOR_LARGE_SIZE     256
+
+/* The flavor a thumbnail-size is scaled down from */
+#define THUMBNAIL_SIZE_GET_FLAVOR(size) \
+        (((size) > THUMBNAIL_SIZE_LARGER) ? \
+                THUMBNAIL_FLAVOR_LARGE : THUMBNAIL_FLAVOR_NORMAL)
+
+/* State of the thumbnail of a file in the thumbnail-cache */
+typedef enum {
+    RSTTO_THUMBNAIL_STATE_UNKNOWN = 0, /* Not looked at yet */
+    RSTTO_THUMBNAIL_STATE_QUEUED,      /* Missing, being generated */
+    RSTTO_THUMBNAIL_STATE_VALID,       /* Thumb::MTime matches the file */
+    RSTTO_THUMBNAIL_STATE_STALE,       /* Outdated, being regenerated */
+    RSTTO_THUMBNAIL_STATE_FAILED,      /* Could not be generated */
+} RsttoThumbnailState;
+
 #define THUMBNAIL_SIZE_VERY_SMALL_SIZE   24
 #define THUMBNAIL_SIZE_SMALLER_SIZE      32
 #define THUMBNAIL_SIZE_SMALL_SIZE        48